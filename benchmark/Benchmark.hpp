@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Benchmark {
+
+inline std::string readFile(const std::string& path) {
+	std::string content(std::filesystem::file_size(path), '\0');
+	std::ifstream file(path);
+	file.read(content.data(), content.size());
+	return content;
+}
+
+// Collects the given .gr files, or the published specification when none are given.
+inline std::vector<std::string> collectPaths(int argc, char** argv, int first = 1) {
+	std::vector<std::string> paths;
+
+	for (int i = first; i < argc; i += 1) {
+		paths.push_back(argv[i]);
+	}
+
+	if (paths.empty()) {
+		for (const auto& entry : std::filesystem::directory_iterator("resource/spec/published")) {
+			if (entry.path().extension() == ".gr") {
+				paths.push_back(entry.path().string());
+			}
+		}
+
+		std::sort(paths.begin(), paths.end());
+	}
+
+	return paths;
+}
+
+// Concatenates the files and repeats them until the corpus reaches the requested size.
+inline std::string readCorpus(const std::vector<std::string>& paths, size_t minimumSize) {
+	std::string unit;
+
+	for (const std::string& path : paths) {
+		unit.append(readFile(path));
+		unit.append("\n\n");
+	}
+
+	std::string corpus;
+
+	if (unit.empty()) {
+		return corpus;
+	}
+
+	corpus.reserve(minimumSize + unit.size());
+
+	while (corpus.size() < minimumSize) {
+		corpus.append(unit);
+	}
+
+	return corpus;
+}
+
+// Runs the function several times and returns the fastest run in seconds.
+template <typename Function>
+double measure(Function function, size_t repeat = 5) {
+	double best = 0;
+
+	for (size_t i = 0; i < repeat; i += 1) {
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		if (i == 0 || elapsed.count() < best) {
+			best = elapsed.count();
+		}
+	}
+
+	return best;
+}
+
+inline void reportThroughput(std::string_view name, size_t bytes, double seconds) {
+	std::printf("%-32.*s %10.1f MB/s %10.3f ms\n", static_cast<int>(name.size()), name.data(), bytes / seconds / 1e6, seconds * 1e3);
+}
+
+}
@@ -0,0 +1,54 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Lexer.hpp"
+#include <random>
+
+using namespace Gularen;
+
+// Keystrokes at random places of the corpus, lexed again as a whole
+// and incrementally, with the bytes the incremental lexer had to look at.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 4 * 1024 * 1024);
+	std::string_view keys = "abc ,.\n";
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	constexpr size_t keystrokeCount = 200;
+
+	std::mt19937 random(1);
+	std::vector<Lexer::Edit> edits;
+	std::vector<char> inserts;
+
+	for (size_t i = 0; i < keystrokeCount; i += 1) {
+		edits.push_back(Lexer::Edit { random() % corpus.size(), 0, 1 });
+		inserts.push_back(keys[random() % keys.size()]);
+	}
+
+	std::string content = corpus;
+	Lexer lexer;
+	size_t lexedSize = 0;
+
+	double seconds = Benchmark::measure([&]() {
+		content = corpus;
+
+		for (size_t i = 0; i < keystrokeCount; i += 1) {
+			content.insert(content.begin() + edits[i].offset, inserts[i]);
+			lexer.parse(content);
+		}
+	}, 1);
+
+	std::printf("%-32s %10.3f ms/keystroke\n", "lexer/whole", seconds * 1e3 / keystrokeCount);
+
+	content = corpus;
+	lexer.parse(content);
+
+	seconds = Benchmark::measure([&]() {
+		for (size_t i = 0; i < keystrokeCount; i += 1) {
+			content.insert(content.begin() + edits[i].offset, inserts[i]);
+			lexedSize += lexer.edit(content, edits[i]);
+		}
+	}, 1);
+
+	std::printf("%-32s %10.3f ms/keystroke %10zu bytes/keystroke\n", "lexer/edit", seconds * 1e3 / keystrokeCount, lexedSize / keystrokeCount);
+
+	return 0;
+}
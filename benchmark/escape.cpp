@@ -0,0 +1,179 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+#include "Gularen/Backend/Html/Composer.hpp"
+#include "Gularen/Backend/Json/Composer.hpp"
+
+using namespace Gularen;
+
+// the JSON escaping one byte at a time the kernels replaced, every byte past ASCII decoded into a unicode escape
+static void escapeJsonBytes(std::string_view content, Sink& sink) {
+	static const char* digits = "0123456789ABCDEF";
+	size_t i = 0;
+
+	while (i < content.size()) {
+		unsigned char byte = content[i];
+
+		switch (byte) {
+			case '"': sink.append("\\\""); i += 1; continue;
+			case '\\': sink.append("\\\\"); i += 1; continue;
+			case '/': sink.append("\\/"); i += 1; continue;
+			case 8: sink.append("\\b"); i += 1; continue;
+			case 12: sink.append("\\f"); i += 1; continue;
+			case '\r': sink.append("\\r"); i += 1; continue;
+			case '\n': sink.append("\\n"); i += 1; continue;
+			case '\t': sink.append("\\t"); i += 1; continue;
+		}
+
+		if (byte >= ' ' && byte <= '~') {
+			sink.append(1, byte);
+			i += 1;
+			continue;
+		}
+
+		unsigned int codepoint = byte;
+
+		if ((i + 1) < content.size() && (byte & 0b11100000) == 0b11000000) {
+			codepoint = ((byte & 0b00011111) << 6) | (content[i + 1] & 0b00111111);
+			i += 2;
+		} else if ((i + 2) < content.size() && (byte & 0b11110000) == 0b11100000) {
+			codepoint = ((byte & 0b00001111) << 12) | ((content[i + 1] & 0b00111111) << 6) | (content[i + 2] & 0b00111111);
+			i += 3;
+		} else if ((i + 3) < content.size() && (byte & 0b11111000) == 0b11110000) {
+			codepoint = ((byte & 0b00000111) << 18) | ((content[i + 1] & 0b00111111) << 12) | ((content[i + 2] & 0b00111111) << 6) | (content[i + 3] & 0b00111111);
+			i += 4;
+		} else {
+			i += 1;
+		}
+
+		char escaped[6] = { '\\', 'u', digits[(codepoint >> 12) & 0x0F], digits[(codepoint >> 8) & 0x0F], digits[(codepoint >> 4) & 0x0F], digits[codepoint & 0x0F] };
+		sink.append(escaped, sizeof(escaped));
+	}
+}
+
+// the HTML escaping one byte at a time the kernels replaced
+static void escapeBytes(std::string_view content, Sink& sink) {
+	for (size_t i = 0; i < content.size(); i += 1) {
+		switch (content[i]) {
+			case '<': sink.append("&lt;"); break;
+			case '>': sink.append("&gt;"); break;
+			case '&': sink.append("&amp;"); break;
+			case '\"': sink.append("&quot;"); break;
+			case '\'': sink.append("&#39;"); break;
+			default: sink.append(1, content[i]); break;
+		}
+	}
+}
+
+// HTML and JSON escaping throughput one byte at a time and for every escaper kernel the machine
+// supports, both on the raw documents and through the whole composers.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 16 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	struct Entry {
+		Html::Escaper::Kernel kernel;
+		std::string_view name;
+	};
+
+	Entry entries[] = {
+		{ Html::Escaper::Kernel::scalar, "scalar" },
+		{ Html::Escaper::Kernel::sse2, "sse2" },
+		{ Html::Escaper::Kernel::avx2, "avx2" },
+	};
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	StringSink sink;
+
+	double seconds = Benchmark::measure([&]() {
+		sink.clear();
+		escapeBytes(content, sink);
+	});
+
+	Benchmark::reportThroughput("html/escape/byte", content.size(), seconds);
+
+	for (const Entry& entry : entries) {
+		if (!Html::Escaper::isSupported(entry.kernel)) {
+			std::printf("%-32.*s unsupported\n", static_cast<int>(entry.name.size()), entry.name.data());
+			continue;
+		}
+
+		Html::Escaper::setKernel(entry.kernel);
+
+		double seconds = Benchmark::measure([&]() {
+			sink.clear();
+			Html::Escaper::escape(content, sink);
+		});
+
+		std::string name = "html/escape/" + std::string(entry.name);
+		Benchmark::reportThroughput(name, content.size(), seconds);
+	}
+
+	std::printf("\n");
+
+	Parser parser;
+	parser.setFileInclusion(false);
+	Document* document = parser.parse(content);
+	Html::Composer htmlComposer;
+
+	for (const Entry& entry : entries) {
+		if (!Html::Escaper::isSupported(entry.kernel)) {
+			continue;
+		}
+
+		Html::Escaper::setKernel(entry.kernel);
+
+		double seconds = Benchmark::measure([&]() {
+			htmlComposer.compose(document);
+		});
+
+		std::string name = "html/compose/" + std::string(entry.name);
+		Benchmark::reportThroughput(name, content.size(), seconds);
+	}
+
+	std::printf("\n");
+
+	seconds = Benchmark::measure([&]() {
+		sink.clear();
+		escapeJsonBytes(content, sink);
+	});
+
+	Benchmark::reportThroughput("json/escape/byte", content.size(), seconds);
+
+	for (const Entry& entry : entries) {
+		if (!Json::Escaper::isSupported(entry.kernel)) {
+			continue;
+		}
+
+		Json::Escaper::setKernel(entry.kernel);
+
+		double seconds = Benchmark::measure([&]() {
+			sink.clear();
+			Json::Escaper::escape(content, sink);
+		});
+
+		std::string name = "json/escape/" + std::string(entry.name);
+		Benchmark::reportThroughput(name, content.size(), seconds);
+	}
+
+	std::printf("\n");
+
+	Json::Composer jsonComposer;
+
+	for (const Entry& entry : entries) {
+		if (!Json::Escaper::isSupported(entry.kernel)) {
+			continue;
+		}
+
+		Json::Escaper::setKernel(entry.kernel);
+
+		double seconds = Benchmark::measure([&]() {
+			jsonComposer.compose(document);
+		});
+
+		std::string name = "json/compose/" + std::string(entry.name);
+		Benchmark::reportThroughput(name, content.size(), seconds);
+	}
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/FlatDocument.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+
+using namespace Gularen;
+
+struct Counts {
+	size_t words = 0;
+	size_t tags = 0;
+	size_t tasks = 0;
+
+	void count(NodeKind kind, std::string_view content) {
+		switch (kind) {
+			case NodeKind::text:
+				words += _countWords(content);
+				break;
+			case NodeKind::accountTag:
+			case NodeKind::hashTag:
+				tags += 1;
+				break;
+			case NodeKind::checkItem:
+				tasks += 1;
+				break;
+			default:
+				break;
+		}
+	}
+
+	static size_t _countWords(std::string_view content) {
+		size_t words = 0;
+		bool inWord = false;
+
+		for (char character : content) {
+			bool space = character == ' ' || character == '\t' || character == '\n';
+			words += !space && !inWord;
+			inWord = !space;
+		}
+
+		return words;
+	}
+};
+
+static void countTree(const Node* node, Counts& counts) {
+	counts.count(node->kind, node->kind == NodeKind::text ? static_cast<const Text*>(node)->content : std::string_view());
+
+	for (const Node* child : node->children) {
+		countTree(child, counts);
+	}
+}
+
+// The kind of pass an analytics job makes, counting words, tags and tasks, over the node tree and the flat form.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 16 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	Parser treeParser;
+	treeParser.setFileInclusion(false);
+	Document* document = treeParser.parse(content);
+
+	// the tree it is taken from gives up its files, so it is a parse of its own
+	Parser flatParser;
+	flatParser.setFileInclusion(false);
+	FlatDocument flat;
+	flat.assign(flatParser.parse(content));
+
+	Counts treeCounts;
+	Counts flatCounts;
+
+	double treeSeconds = Benchmark::measure([&]() {
+		treeCounts = Counts();
+		countTree(document, treeCounts);
+	});
+
+	double flatSeconds = Benchmark::measure([&]() {
+		flatCounts = Counts();
+
+		for (uint32_t node = 0; node < flat.size(); node += 1) {
+			NodeKind kind = flat.kinds[node];
+			flatCounts.count(kind, kind == NodeKind::text ? flat.viewsOf(node)[0] : std::string_view());
+		}
+	});
+
+	// only the tags, a pass that never looks past the kinds
+	size_t tags = 0;
+
+	double kindSeconds = Benchmark::measure([&]() {
+		tags = 0;
+
+		for (NodeKind kind : flat.kinds) {
+			tags += kind == NodeKind::accountTag || kind == NodeKind::hashTag;
+		}
+	});
+
+	bool same = treeCounts.words == flatCounts.words && treeCounts.tags == flatCounts.tags && treeCounts.tasks == flatCounts.tasks && tags == flatCounts.tags;
+
+	Benchmark::reportThroughput("count/tree", content.size(), treeSeconds);
+	Benchmark::reportThroughput("count/flat", content.size(), flatSeconds);
+	Benchmark::reportThroughput("count/flat/tags", content.size(), kindSeconds);
+	std::printf("%zu nodes, %zu words, %zu tags, %zu tasks %s\n", flat.size(), flatCounts.words, flatCounts.tags, flatCounts.tasks, same ? "identical" : "DIFFERENT");
+
+	return 0;
+}
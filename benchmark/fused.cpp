@@ -0,0 +1,57 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+#include <thread>
+
+using namespace Gularen;
+
+// The parser driving the lexer token by token against lexing the whole content into
+// a token array first and parsing that, on one thread and on the hardware threads.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 16 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	std::vector<size_t> lexingThreadCounts { 0, 1 };
+	size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	if (threadCount > 1) {
+		lexingThreadCounts.push_back(threadCount);
+	}
+
+	// the modes take turns, so none of them gets the memory the allocator has just faulted in or given back
+	std::vector<double> seconds(lexingThreadCounts.size(), 0);
+
+	// sink keeps the runs from being optimized away
+	volatile size_t sink = 0;
+
+	for (size_t round = 0; round < 8; round += 1) {
+		for (size_t i = 0; i < lexingThreadCounts.size(); i += 1) {
+			double elapsed = Benchmark::measure([&]() {
+				Parser parser;
+				parser.setFileInclusion(false);
+				parser.setLexingThreadCount(lexingThreadCounts[i]);
+				sink = parser.parse(content)->children.size();
+			}, 1);
+
+			if (round == 0 || elapsed < seconds[i]) {
+				seconds[i] = elapsed;
+			}
+		}
+	}
+
+	Benchmark::reportThroughput("parser/fused", content.size(), seconds[0]);
+	Benchmark::reportThroughput("parser/two-phase", content.size(), seconds[1]);
+
+	if (lexingThreadCounts.size() > 2) {
+		std::string name = "parser/two-phase/" + std::to_string(threadCount);
+		Benchmark::reportThroughput(name, content.size(), seconds[2]);
+	}
+
+	Lexer lexer;
+	lexer.parse(content);
+
+	std::printf("\n%-32s %10zu bytes for %zu tokens\n", "two-phase token array", lexer.size() * sizeof(Token), lexer.size());
+
+	return 0;
+}
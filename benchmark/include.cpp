@@ -0,0 +1,68 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+#include <thread>
+
+using namespace Gularen;
+
+// A batch of books that include the same chapters, every inclusion parsed again against
+// the inclusions shared through a cache, and the inclusions of a book parsed on the hardware
+// threads before the book. Pass the including files, the specification by default.
+int main(int argc, char** argv) {
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; i += 1) {
+		paths.push_back(argv[i]);
+	}
+
+	if (paths.empty()) {
+		paths.push_back("resource/spec/published/master.gr");
+	}
+
+	size_t bookCount = 100;
+
+	std::printf("corpus: %zu books of %zu files\n\n", bookCount, paths.size());
+
+	// sink keeps the runs from being optimized away
+	volatile size_t sink = 0;
+
+	double seconds = Benchmark::measure([&]() {
+		for (size_t book = 0; book < bookCount; book += 1) {
+			for (const std::string& path : paths) {
+				Parser parser;
+				sink = parser.parseFile(path)->children.size();
+			}
+		}
+	});
+
+	size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	double prefetchedSeconds = Benchmark::measure([&]() {
+		for (size_t book = 0; book < bookCount; book += 1) {
+			for (const std::string& path : paths) {
+				Parser parser;
+				parser.setInclusionThreadCount(threadCount);
+				sink = parser.parseFile(path)->children.size();
+			}
+		}
+	});
+
+	IncludeCache cache;
+
+	double cachedSeconds = Benchmark::measure([&]() {
+		for (size_t book = 0; book < bookCount; book += 1) {
+			for (const std::string& path : paths) {
+				Parser parser;
+				parser.setIncludeCache(&cache);
+				sink = parser.parseFile(path)->children.size();
+			}
+		}
+	});
+
+	std::printf("%-32s %10.3f ms\n", "include/parsed", seconds * 1e3);
+	std::string name = "include/prefetched/" + std::to_string(threadCount);
+	std::printf("%-32s %10.3f ms %6.2fx\n", name.c_str(), prefetchedSeconds * 1e3, seconds / prefetchedSeconds);
+	std::printf("%-32s %10.3f ms %6.2fx\n", "include/cached", cachedSeconds * 1e3, seconds / cachedSeconds);
+	std::printf("\n%-32s %10zu hits %zu misses\n", "include/cache", cache.hits(), cache.misses());
+
+	return 0;
+}
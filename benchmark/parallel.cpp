@@ -0,0 +1,54 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Lexer.hpp"
+#include <thread>
+
+using namespace Gularen;
+
+// Lexer throughput from one thread up to the hardware threads, checked against the sequential tokens.
+// Pass a thread count as the first argument to go past the hardware threads.
+int main(int argc, char** argv) {
+	size_t maximumThreadCount = std::max(1u, std::thread::hardware_concurrency());
+	int first = 1;
+
+	if (argc > 1 && std::string_view(argv[1]).find(".gr") == std::string_view::npos) {
+		maximumThreadCount = std::stoul(argv[1]);
+		first = 2;
+	}
+
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv, first), 64 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	// fresh lexers, a reused one would keep its token buffer
+	double base = Benchmark::measure([&]() {
+		Lexer lexer;
+		lexer.parse(content);
+	}, 3);
+
+	Benchmark::reportThroughput("lexer/sequential", content.size(), base);
+
+	Lexer sequential;
+	sequential.parse(content);
+
+	for (size_t threadCount = 1; threadCount <= maximumThreadCount; threadCount *= 2) {
+		double seconds = Benchmark::measure([&]() {
+			Lexer lexer;
+			lexer.parse(content, threadCount);
+		}, 3);
+
+		Lexer lexer;
+		lexer.parse(content, threadCount);
+
+		bool same = lexer.size() == sequential.size();
+
+		for (size_t i = 0; same && i < lexer.size(); i += 1) {
+			same = std::memcmp(&lexer[i], &sequential[i], sizeof(Token)) == 0;
+		}
+
+		std::string name = "lexer/parallel/" + std::to_string(threadCount);
+		std::printf("%-32s %10.1f MB/s %10.3f ms %6.2fx %s\n", name.c_str(), content.size() / seconds / 1e6, seconds * 1e3, base / seconds, same ? "identical" : "DIFFERENT");
+	}
+
+	return 0;
+}
@@ -0,0 +1,62 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+#include "Gularen/Backend/Html/Composer.hpp"
+#include "Gularen/Backend/Json/Composer.hpp"
+#include "Gularen/Backend/Markdown/Composer.hpp"
+
+using namespace Gularen;
+
+template <typename Composer>
+static void run(std::string_view name, Document* document) {
+	Composer composer;
+	size_t growthCount = 0;
+
+	// a fresh sink grows from its first few bytes, like the output string used to
+	double grownSeconds = Benchmark::measure([&]() {
+		StringSink sink;
+		composer.compose(document, sink);
+		growthCount = sink.growthCount();
+	});
+
+	double reservedSeconds = Benchmark::measure([&]() {
+		StringSink sink;
+		sink.reserve(Composer::estimate(document));
+		composer.compose(document, sink);
+	});
+
+	double estimateSeconds = Benchmark::measure([&]() {
+		Composer::estimate(document);
+	});
+
+	composer.compose(document);
+	OutputStats stats = composer.stats();
+
+	std::string grownName = std::string(name) + "/grown";
+	std::string reservedName = std::string(name) + "/reserved";
+	std::string estimateName = std::string(name) + "/estimate";
+
+	Benchmark::reportThroughput(grownName, stats.size, grownSeconds);
+	Benchmark::reportThroughput(reservedName, stats.size, reservedSeconds);
+	std::printf("%-32s %10.3f ms\n", estimateName.c_str(), estimateSeconds * 1e3);
+	std::printf("%-32s %10zu bytes estimated for %zu, %.2fx\n", "", stats.estimatedSize, stats.size, static_cast<double>(stats.estimatedSize) / stats.size);
+	std::printf("%-32s %10zu growths reserved, %zu grown\n\n", "", stats.growthCount, growthCount);
+}
+
+// Composing into memory with the output reserved once from the estimate of the size hint,
+// against growing the output as it comes. Reports how close the estimate was and how often each grew.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 16 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	Parser parser;
+	parser.setFileInclusion(false);
+	Document* document = parser.parse(content);
+
+	run<Html::Composer>("html", document);
+	run<Json::Composer>("json", document);
+	run<Markdown::Composer>("markdown", document);
+
+	return 0;
+}
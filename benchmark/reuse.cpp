@@ -0,0 +1,91 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+#include <cstdlib>
+#include <new>
+
+using namespace Gularen;
+
+// every allocation of the process goes through here
+static size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+	allocationCount += 1;
+
+	if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+		return pointer;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+// A worker converting many small documents, a new parser for each against one parser that is reset,
+// and how often each asks the allocator once the reused one has seen the largest document.
+int main(int argc, char** argv) {
+	std::vector<std::string> documents;
+
+	for (const std::string& path : Benchmark::collectPaths(argc, argv)) {
+		documents.push_back(Benchmark::readFile(path));
+	}
+
+	size_t size = 0;
+
+	for (const std::string& document : documents) {
+		size += document.size();
+	}
+
+	std::printf("corpus: %zu documents, %zu bytes\n\n", documents.size(), size);
+
+	// sink keeps the runs from being optimized away
+	volatile size_t sink = 0;
+	size_t rounds = 200;
+
+	size_t allocations = allocationCount;
+
+	double seconds = Benchmark::measure([&]() {
+		for (size_t round = 0; round < rounds; round += 1) {
+			for (const std::string& document : documents) {
+				Parser parser;
+				parser.setFileInclusion(false);
+				sink = parser.parse(document)->children.size();
+			}
+		}
+	});
+
+	size_t freshAllocations = (allocationCount - allocations) / 5;
+
+	Parser parser;
+	parser.setFileInclusion(false);
+
+	// one pass to grow every buffer to the largest document
+	for (const std::string& document : documents) {
+		parser.parse(document);
+	}
+
+	allocations = allocationCount;
+
+	double reusedSeconds = Benchmark::measure([&]() {
+		for (size_t round = 0; round < rounds; round += 1) {
+			for (const std::string& document : documents) {
+				sink = parser.parse(document)->children.size();
+			}
+		}
+	});
+
+	size_t reusedAllocations = (allocationCount - allocations) / 5;
+	size_t documentCount = rounds * documents.size();
+
+	Benchmark::reportThroughput("parser/fresh", size * rounds, seconds);
+	Benchmark::reportThroughput("parser/reused", size * rounds, reusedSeconds);
+	std::printf("\n%-32s %10.2f per document\n", "parser/fresh allocations", static_cast<double>(freshAllocations) / documentCount);
+	std::printf("%-32s %10.2f per document\n", "parser/reused allocations", static_cast<double>(reusedAllocations) / documentCount);
+
+	return 0;
+}
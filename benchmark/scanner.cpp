@@ -0,0 +1,64 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Lexer.hpp"
+
+using namespace Gularen;
+
+// Text-run scanning throughput for every scanner kernel the machine supports,
+// both in isolation and through the whole lexer.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 16 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	struct Entry {
+		Scanner::Kernel kernel;
+		std::string_view name;
+	};
+
+	Entry entries[] = {
+		{ Scanner::Kernel::scalar, "scalar" },
+		{ Scanner::Kernel::sse2, "sse2" },
+		{ Scanner::Kernel::avx2, "avx2" },
+	};
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	for (const Entry& entry : entries) {
+		if (!Scanner::isSupported(entry.kernel)) {
+			std::printf("%-32.*s unsupported\n", static_cast<int>(entry.name.size()), entry.name.data());
+			continue;
+		}
+
+		Scanner::setKernel(entry.kernel);
+
+		double seconds = Benchmark::measure([&]() {
+			size_t index = 0;
+
+			while (index < content.size()) {
+				index = Scanner::skipPlain(content, index) + 1;
+			}
+		});
+
+		std::string name = "scan/" + std::string(entry.name);
+		Benchmark::reportThroughput(name, content.size(), seconds);
+	}
+
+	std::printf("\n");
+
+	for (const Entry& entry : entries) {
+		if (!Scanner::isSupported(entry.kernel)) {
+			continue;
+		}
+
+		Scanner::setKernel(entry.kernel);
+
+		double seconds = Benchmark::measure([&]() {
+			Lexer lexer;
+			lexer.parse(content);
+		});
+
+		std::string name = "lexer/" + std::string(entry.name);
+		Benchmark::reportThroughput(name, content.size(), seconds);
+	}
+
+	return 0;
+}
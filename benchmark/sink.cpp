@@ -0,0 +1,101 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+#include "Gularen/Backend/Html/Composer.hpp"
+#include "Gularen/Backend/Json/Composer.hpp"
+#include "Gularen/Backend/Markdown/Composer.hpp"
+#include <fcntl.h>
+#include <sys/resource.h>
+
+using namespace Gularen;
+
+// peak resident set of the process in MB
+static double peakResidentSize() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	#ifdef __APPLE__
+	return usage.ru_maxrss / 1e6;
+	#else
+	return usage.ru_maxrss / 1e3;
+	#endif
+}
+
+// Every composer writing a large document into a file through a fixed buffer against
+// composing the whole output in memory first. The file runs go first, the peak resident
+// set only grows, so what the in memory runs add on top shows up on its own.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 16 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	Parser parser;
+	parser.setFileInclusion(false);
+	Document* document = parser.parse(content);
+
+	int descriptor = open("/dev/null", O_WRONLY);
+
+	if (descriptor < 0) {
+		std::printf("cannot open /dev/null\n");
+		return 1;
+	}
+
+	Html::Composer html;
+	Json::Composer json;
+	Markdown::Composer markdown;
+
+	double residentSize = peakResidentSize();
+
+	double htmlFileSeconds = Benchmark::measure([&]() {
+		FileSink sink(descriptor);
+		html.compose(document, sink);
+	});
+
+	double jsonFileSeconds = Benchmark::measure([&]() {
+		FileSink sink(descriptor);
+		json.compose(document, sink);
+	});
+
+	double markdownFileSeconds = Benchmark::measure([&]() {
+		FileSink sink(descriptor);
+		markdown.compose(document, sink);
+	});
+
+	double fileResidentSize = peakResidentSize() - residentSize;
+
+	// sink keeps the runs from being optimized away
+	volatile size_t sink = 0;
+	size_t htmlSize = 0;
+	size_t jsonSize = 0;
+	size_t markdownSize = 0;
+
+	double htmlSeconds = Benchmark::measure([&]() {
+		Html::Composer composer;
+		sink = htmlSize = composer.compose(document).size();
+	});
+
+	double jsonSeconds = Benchmark::measure([&]() {
+		Json::Composer composer;
+		sink = jsonSize = composer.compose(document).size();
+	});
+
+	double markdownSeconds = Benchmark::measure([&]() {
+		Markdown::Composer composer;
+		sink = markdownSize = composer.compose(document).size();
+	});
+
+	double stringResidentSize = peakResidentSize() - residentSize;
+
+	close(descriptor);
+
+	Benchmark::reportThroughput("html/string", htmlSize, htmlSeconds);
+	Benchmark::reportThroughput("html/file", htmlSize, htmlFileSeconds);
+	Benchmark::reportThroughput("json/string", jsonSize, jsonSeconds);
+	Benchmark::reportThroughput("json/file", jsonSize, jsonFileSeconds);
+	Benchmark::reportThroughput("markdown/string", markdownSize, markdownSeconds);
+	Benchmark::reportThroughput("markdown/file", markdownSize, markdownFileSeconds);
+	std::printf("\n%-32s %10.1f MB above the document\n", "file/peak", fileResidentSize);
+	std::printf("%-32s %10.1f MB above the document\n", "string/peak", stringResidentSize);
+
+	return 0;
+}
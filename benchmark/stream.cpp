@@ -0,0 +1,60 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+#include <sstream>
+
+using namespace Gularen;
+
+// Whole-content parsing against chunked streaming, and the largest input window
+// the streaming lexer holds while the corpus passes through it.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 16 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	// sink keeps the runs from being optimized away
+	volatile size_t sink = 0;
+
+	double seconds = Benchmark::measure([&]() {
+		Parser parser;
+		parser.setFileInclusion(false);
+		sink = parser.parse(content)->children.size();
+	});
+
+	Benchmark::reportThroughput("parser/whole", content.size(), seconds);
+
+	seconds = Benchmark::measure([&]() {
+		std::istringstream stream(corpus);
+		size_t blockCount = 0;
+
+		Parser parser;
+		parser.setFileInclusion(false);
+		parser.parseStream(stream, [&](const Document&, Node*) {
+			blockCount += 1;
+		});
+
+		sink = blockCount;
+	});
+
+	Benchmark::reportThroughput("parser/stream", content.size(), seconds);
+
+	size_t position = 0;
+	size_t window = 0;
+
+	Lexer lexer;
+	lexer.stream([&](char* buffer, size_t size) {
+		size = std::min(size, content.size() - position);
+		std::memcpy(buffer, content.data() + position, size);
+		position += size;
+		return size;
+	});
+
+	for (size_t i = 0; lexer.fetch(i); i += 1) {
+		lexer.discard(i);
+		window = std::max(window, lexer.window().size());
+	}
+
+	std::printf("\n%-32s %10zu bytes for %zu tokens\n", "lexer/stream peak window", window, lexer.size());
+
+	return 0;
+}
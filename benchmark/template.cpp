@@ -0,0 +1,74 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+#include "Gularen/Backend/Html/TemplateManager.hpp"
+
+using namespace Gularen;
+
+// A template with the content and the table of contents, rendered with a composer of its own
+// for each of them like the template manager used to against the one pass of a shared composer.
+// Pass the document and the template, the article of the cli by default.
+int main(int argc, char** argv) {
+	std::string documentPath = argc > 1 ? argv[1] : "cli/resource/html/article.gr";
+	std::string templatePath = argc > 2 ? argv[2] : "cli/resource/html/article.template.html";
+
+	Parser parser;
+	Document* document = parser.parseFile(documentPath);
+
+	Html::TemplateManager templateManager;
+	templateManager.setDocument(document);
+	templateManager.setTemplateFile(templatePath);
+
+	size_t size = templateManager.render().size();
+	size_t rounds = 2000;
+
+	std::printf("document: %s, %zu bytes rendered, %zu rounds\n\n", documentPath.c_str(), size, rounds);
+
+	StringSink content;
+	StringSink toc;
+
+	double separateSeconds = Benchmark::measure([&]() {
+		for (size_t round = 0; round < rounds; round += 1) {
+			content.clear();
+			toc.clear();
+
+			Html::Composer contentComposer;
+			contentComposer.compose(document, content);
+
+			Html::Composer tocComposer;
+			tocComposer.composeToc(document, toc);
+		}
+	});
+
+	Html::Composer composer;
+
+	// one composer for both but still a pass for each
+	double reusedSeconds = Benchmark::measure([&]() {
+		for (size_t round = 0; round < rounds; round += 1) {
+			content.clear();
+			toc.clear();
+			composer.compose(document, content);
+			composer.composeToc(document, toc);
+		}
+	});
+
+	double sharedSeconds = Benchmark::measure([&]() {
+		for (size_t round = 0; round < rounds; round += 1) {
+			content.clear();
+			toc.clear();
+			composer.compose(document, content, toc);
+		}
+	});
+
+	double renderSeconds = Benchmark::measure([&]() {
+		for (size_t round = 0; round < rounds; round += 1) {
+			templateManager.render();
+		}
+	});
+
+	Benchmark::reportThroughput("compose/separate", content.size() * rounds, separateSeconds);
+	Benchmark::reportThroughput("compose/reused", content.size() * rounds, reusedSeconds);
+	Benchmark::reportThroughput("compose/shared", content.size() * rounds, sharedSeconds);
+	Benchmark::reportThroughput("render/shared", size * rounds, renderSeconds);
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Lexer.hpp"
+#include "Gularen/Library/LineIndex.hpp"
+
+using namespace Gularen;
+
+// The token layout before offsets, kept here to compare footprints.
+struct WideToken {
+	size_t startLine;
+	size_t startColumn;
+	size_t endLine;
+	size_t endColumn;
+	TokenKind kind;
+	std::string_view content;
+};
+
+// Token memory and the cost of walking the token stream the way the parser does,
+// once over compact tokens and once over the wide layout with resolved ranges.
+// The walk is memory bound, run it under `perf stat -e cache-misses` to see the misses.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 16 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	Lexer lexer;
+	lexer.parse(content);
+
+	std::vector<Token> tokens;
+	std::vector<WideToken> wideTokens;
+	tokens.reserve(lexer.size());
+	wideTokens.reserve(lexer.size());
+
+	LineIndex lineIndex(content);
+
+	for (size_t i = 0; i < lexer.size(); i += 1) {
+		Range range = lexer.range(lexer[i]);
+		Position start = lineIndex.position(range.begin);
+		Position end = lineIndex.position(range.end);
+
+		tokens.push_back(lexer[i]);
+		wideTokens.push_back(WideToken { start.line, start.column, end.line, end.column, lexer[i].kind, lexer.content(lexer[i]) });
+	}
+
+	std::printf("corpus: %zu bytes, %zu tokens\n\n", corpus.size(), tokens.size());
+	std::printf("%-32s %10zu bytes/token %10.1f MB\n", "memory/compact", sizeof(Token), tokens.size() * sizeof(Token) / 1e6);
+	std::printf("%-32s %10zu bytes/token %10.1f MB\n", "memory/wide", sizeof(WideToken), wideTokens.size() * sizeof(WideToken) / 1e6);
+	std::printf("\n");
+
+	// sink keeps the walks from being optimized away
+	volatile size_t sink = 0;
+
+	double seconds = Benchmark::measure([&]() {
+		size_t sum = 0;
+
+		for (const Token& token : tokens) {
+			if (token.kind == TokenKind::text) {
+				sum += token.size;
+			}
+		}
+
+		sink = sum;
+	});
+
+	Benchmark::reportThroughput("walk/compact", content.size(), seconds);
+
+	seconds = Benchmark::measure([&]() {
+		size_t sum = 0;
+
+		for (const WideToken& token : wideTokens) {
+			if (token.kind == TokenKind::text) {
+				sum += token.content.size();
+			}
+		}
+
+		sink = sum;
+	});
+
+	Benchmark::reportThroughput("walk/wide", content.size(), seconds);
+
+	seconds = Benchmark::measure([&]() {
+		Lexer lexer;
+		lexer.parse(content);
+		sink = lexer.size();
+	});
+
+	Benchmark::reportThroughput("lexer", content.size(), seconds);
+
+	// a batch converter keeps its lexer, the token buffer is sized once and kept
+	Lexer reusedLexer;
+
+	seconds = Benchmark::measure([&]() {
+		reusedLexer.parse(content);
+		sink = reusedLexer.size();
+	});
+
+	Benchmark::reportThroughput("lexer/reused", content.size(), seconds);
+
+	// only paid by callers that ask for a line and column
+	seconds = Benchmark::measure([&]() {
+		LineIndex lineIndex(content);
+		sink = lineIndex.position(content.size()).line;
+	});
+
+	Benchmark::reportThroughput("lineIndex", content.size(), seconds);
+
+	return 0;
+}
@@ -0,0 +1,60 @@
+#include "Benchmark.hpp"
+#include "Gularen/Frontend/Parser.hpp"
+#include <sys/resource.h>
+
+using namespace Gularen;
+
+// peak resident set of the process in MB
+static double peakResidentSize() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	#ifdef __APPLE__
+	return usage.ru_maxrss / 1e6;
+	#else
+	return usage.ru_maxrss / 1e3;
+	#endif
+}
+
+// Building and tearing down the AST of a large document.
+// Only the public parser API is used, so the same file builds on older trees to compare against.
+int main(int argc, char** argv) {
+	std::string corpus = Benchmark::readCorpus(Benchmark::collectPaths(argc, argv), 16 * 1024 * 1024);
+	std::string_view content(corpus.data(), corpus.size());
+
+	std::printf("corpus: %zu bytes\n\n", corpus.size());
+
+	double residentSize = peakResidentSize();
+	double parseSeconds = 0;
+	double destroySeconds = 0;
+
+	for (size_t i = 0; i < 5; i += 1) {
+		Parser* parser = new Parser();
+		parser->setFileInclusion(false);
+
+		auto start = std::chrono::steady_clock::now();
+		parser->parse(content);
+		auto middle = std::chrono::steady_clock::now();
+
+		// the parser owns the document
+		delete parser;
+		auto end = std::chrono::steady_clock::now();
+
+		std::chrono::duration<double> parse = middle - start;
+		std::chrono::duration<double> destroy = end - middle;
+
+		if (i == 0 || parse.count() < parseSeconds) {
+			parseSeconds = parse.count();
+		}
+
+		if (i == 0 || destroy.count() < destroySeconds) {
+			destroySeconds = destroy.count();
+		}
+	}
+
+	Benchmark::reportThroughput("tree/parse", content.size(), parseSeconds);
+	Benchmark::reportThroughput("tree/destroy", content.size(), destroySeconds);
+	std::printf("%-32s %10.1f MB above the corpus\n", "tree/peak", peakResidentSize() - residentSize);
+
+	return 0;
+}
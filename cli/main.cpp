@@ -2,25 +2,108 @@
 #include "Gularen/Backend/Html/TemplateManager.hpp"
 #include "Gularen/Backend/Markdown/Composer.hpp"
 #include "Gularen/Backend/Json/Composer.hpp"
+#include <fcntl.h>
 #include <iostream>
 
 using namespace Gularen;
 
-void render(std::string_view path, std::string_view content) {
+// Composes straight into the output file, or into the standard output when there is none.
+// Returns false when the output could not be created or written.
+template <typename Compose>
+bool render(std::string_view path, Compose compose) {
+	int descriptor = STDOUT_FILENO;
+
 	if (path.empty()) {
-		std::cout << content;
-		return;
+		// what was printed so far comes first
+		std::cout.flush();
+	} else {
+		descriptor = open(std::string(path).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+		if (descriptor < 0) {
+			std::cout << "cannot create file " << path << "\n";
+			return false;
+		}
+	}
+
+	bool good = true;
+
+	{
+		FileSink sink(descriptor);
+		compose(sink);
+		sink.flush();
+		good = sink.good();
+	}
+
+	if (descriptor != STDOUT_FILENO && close(descriptor) != 0) {
+		good = false;
+	}
+
+	if (!good) {
+		// the standard output may be what failed
+		std::cerr << "cannot write " << (path.empty() ? std::string_view("to the standard output") : path) << "\n";
+	}
+
+	return good;
+}
+
+void printDiagnostics(const Parser& parser) {
+	for (const Diagnostic& diagnostic : parser.diagnostics()) {
+		std::cout << diagnostic.message() << "\n";
+	}
+}
+
+// Composes the document into the target and returns the exit status.
+int convert(Document* document, std::string_view target, std::string_view outputPath, std::string_view templatePath) {
+	if (target == "html") {
+		if (templatePath.size() != 0) {
+			if (!std::filesystem::exists(templatePath)) {
+				std::cout << "template \"" << templatePath << "\" does not exist\n";
+				return 0;
+			}
+
+			if (std::filesystem::is_directory(templatePath)) {
+				std::cout << "\"" << templatePath << "\" is a folder please provide a template file\n";
+				return 0;
+			}
+
+			Html::TemplateManager templateManager;
+			templateManager.setDocument(document);
+			templateManager.setTemplateFile(templatePath);
+			bool written = render(outputPath, [&](Sink& sink) {
+				templateManager.render(sink);
+			});
+
+			return written ? 0 : 1;
+		}
+
+		Html::Composer composer;
+		bool written = render(outputPath, [&](Sink& sink) {
+			composer.compose(document, sink);
+		});
+
+		return written ? 0 : 1;
+	}
+
+	if (target == "md" || target == "markdown") {
+		Markdown::Composer composer;
+		bool written = render(outputPath, [&](Sink& sink) {
+			composer.compose(document, sink);
+		});
+
+		return written ? 0 : 1;
 	}
 
-	std::ofstream file;
-	file.open(std::string(path));
+	if (target == "json") {
+		Json::Composer composer;
+		bool written = render(outputPath, [&](Sink& sink) {
+			composer.compose(document, sink);
+		});
 
-	if (!file.is_open()) {
-		std::cout << "cannot create file " << path << "\n";
-		return;
+		return written ? 0 : 1;
 	}
 
-	file.write(content.data(), content.size());
+	std::cout << "unknown target\n";
+	return 1;
 }
 
 int main(int argc, char** argv) {
@@ -106,52 +189,19 @@ int main(int argc, char** argv) {
 		Document* document = parser.parseFile(inputPath);
 
 		if (document == nullptr) {
+			printDiagnostics(parser);
+
 			std::cout << "failed to parse \"" << inputPath << "\"\n";
 
 			return 1;
 		}
 
-		if (target == "html") {
-			if (templatePath.size() != 0) {
-				if (!std::filesystem::exists(templatePath)) {
-					std::cout << "template \"" << templatePath << "\" does not exist\n";
-					return 0;
-				}
-
-				if (std::filesystem::is_directory(templatePath)) {
-					std::cout << "\"" << templatePath << "\" is a folder please provide a template file\n";
-					return 0;
-				}
-
-				Html::TemplateManager templateManager;
-				templateManager.setDocument(document);
-				templateManager.setTemplateFile(templatePath);
-				render(outputPath, templateManager.render());
-				return 0;
-			}
-
-			Html::Composer composer;
-			render(outputPath, composer.compose(document));
-
-			return 0;
-		}
-
-		if (target == "md" || target == "markdown") {
-			Markdown::Composer composer;
-			render(outputPath, composer.compose(document));
-
-			return 0;
-		}
-
-		if (target == "json") {
-			Json::Composer composer;
-			render(outputPath, composer.compose(document));
+		int status = convert(document, target, outputPath, templatePath);
 
-			return 0;
-		}
+		// what the parser ran into is printed after the output
+		printDiagnostics(parser);
 
-		std::cout << "unknown target\n";
-		return 1;
+		return status;
 	}
 
 	std::cout << "unknown action\n";
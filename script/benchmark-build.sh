@@ -0,0 +1,26 @@
+if [ ! -d 'build' ]; then
+	mkdir build
+fi
+
+OS="`uname`"
+case $OS in
+	'Linux')
+		for path in benchmark/*.cpp
+		do
+			name=$(basename $path .cpp)
+			g++ -o build/gularen-benchmark-$name -std=c++17 -O2 -pthread -I source $path
+		done
+		;;
+
+	'Darwin') 
+		for path in benchmark/*.cpp
+		do
+			name=$(basename $path .cpp)
+			clang++ -o build/gularen-benchmark-$name -std=c++17 -O2 -pthread -I source $path
+		done
+		;;
+
+	*) 
+		echo 'unsupported operating system'
+		;;
+esac
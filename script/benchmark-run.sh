@@ -0,0 +1,8 @@
+sh script/benchmark-build.sh
+
+for path in build/gularen-benchmark-*
+do
+	echo "## $(basename $path)"
+	$path
+	echo
+done
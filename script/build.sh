@@ -5,11 +5,11 @@ fi
 OS="`uname`"
 case $OS in
 	'Linux')
-		g++ -o build/gularen -std=c++17 -I source cli/main.cpp
+		g++ -o build/gularen -std=c++17 -pthread -I source cli/main.cpp
 		;;
 
 	'Darwin') 
-		clang++ -o build/gularen -Wall -std=c++17 -I source cli/main.cpp
+		clang++ -o build/gularen -Wall -std=c++17 -pthread -I source cli/main.cpp
 		;;
 
 	*) 
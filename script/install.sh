@@ -5,12 +5,12 @@ fi
 OS="`uname`"
 case $OS in
 	'Linux')
-		g++ -o build/gularen -std=c++17 -I source cli/main.cpp -O2
+		g++ -o build/gularen -std=c++17 -pthread -I source cli/main.cpp -O2
 		sudo cp build/gularen /usr/local/bin/gularen
 		;;
 
 	'Darwin') 
-		clang++ -o build/gularen -std=c++17 -I source cli/main.cpp -O2
+		clang++ -o build/gularen -std=c++17 -pthread -I source cli/main.cpp -O2
 		sudo cp build/gularen /usr/local/bin/gularen
 		;;
 
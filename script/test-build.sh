@@ -3,11 +3,19 @@ sh script/build.sh
 OS="`uname`"
 case $OS in
 	'Linux')
-		g++ -o build/gularen-test -std=c++17 -I source test/main.cpp
+		g++ -o build/gularen-test -std=c++17 -pthread -I source test/main.cpp
+		g++ -o build/gularen-test-nesting -std=c++17 -pthread -I source test/nesting.cpp
+		g++ -o build/gularen-test-escape -std=c++17 -pthread -I source test/escape.cpp
+		g++ -o build/gularen-test-inclusion -std=c++17 -pthread -I source test/inclusion.cpp
+		g++ -o build/gularen-test-boundary -std=c++17 -pthread -D_GLIBCXX_ASSERTIONS -I source test/boundary.cpp
 		;;
 
 	'Darwin') 
-		clang++ -o build/gularen-test -std=c++17 -I source test/main.cpp
+		clang++ -o build/gularen-test -std=c++17 -pthread -I source test/main.cpp
+		clang++ -o build/gularen-test-nesting -std=c++17 -pthread -I source test/nesting.cpp
+		clang++ -o build/gularen-test-escape -std=c++17 -pthread -I source test/escape.cpp
+		clang++ -o build/gularen-test-inclusion -std=c++17 -pthread -I source test/inclusion.cpp
+		clang++ -o build/gularen-test-boundary -std=c++17 -pthread -D_GLIBCXX_ASSERTIONS -I source test/boundary.cpp
 		;;
 
 	*) 
@@ -30,3 +30,8 @@ do
 		exit
 	fi
 done
+
+./build/gularen-test-nesting
+./build/gularen-test-escape
+./build/gularen-test-inclusion
+./build/gularen-test-boundary
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "Gularen/Frontend/Node.hpp"
+#include "Gularen/Frontend/NodeWalker.hpp"
 #include "Gularen/Backend/EmojiConverter.hpp"
+#include "Gularen/Backend/Html/Escaper.hpp"
+#include "Gularen/Backend/OutputEstimate.hpp"
+#include "Gularen/Library/CharClass.hpp"
+#include "Gularen/Library/Sink.hpp"
 #include <unordered_map>
 
 namespace Gularen {
@@ -9,131 +14,225 @@ namespace Html {
 
 class Composer {
 public:
+	Composer() {
+		_estimatedSize = 0;
+		_tocSink = nullptr;
+	}
+
 	std::string_view compose(Document* document) {
-		_content = std::string();
+		_content.clear();
+		_estimatedSize = estimate(document);
+		_content.reserve(_estimatedSize);
+		compose(document, _content);
+
+		return _content.view();
+	}
+
+	// The size of the output guessed from the size hint of the document, on the large side.
+	static size_t estimate(const Document* document) {
+		if (document == nullptr) {
+			return 0;
+		}
+
+		return OutputEstimate::size(OutputEstimate::of(document), 64, 2, 21);
+	}
+
+	// How the estimate of the last compose() into memory held up.
+	OutputStats stats() const {
+		return OutputStats { _estimatedSize, _content.size(), _content.growthCount() };
+	}
+
+	// Writes the output to the sink as it is composed, the sink is not flushed.
+	void compose(Document* document, Sink& sink) {
+		_tocSink = nullptr;
+		_composeDocument(document, sink);
+	}
+
+	// Writes the output to the sink and the table of contents to toc in the same pass over the tree,
+	// neither sink is flushed. A title is composed once and written to both.
+	void compose(Document* document, Sink& sink, Sink& toc) {
+		_tocSink = &toc;
+		_composeDocument(document, sink);
+		_tocSink = nullptr;
+	}
+
+	std::string_view composeToc(Document* document) {
+		_toc.clear();
+		composeToc(document, _toc);
+
+		return _toc.view();
+	}
+
+	void composeToc(Document* document, Sink& sink) {
+		_composeToc(document, sink);
+	}
+
+private:
+	void _composeDocument(Document* document, Sink& sink) {
 		_tableAlignments = nullptr;
 		_tableColumnIndex = 0;
 		_tableLabel = false;
 
+		// a reused composer does not look up the references of the last document
+		_references.clear();
+
 		if (document != nullptr) {
 			_collectReferences(document);
 
 			for (size_t i = 0; i < document->children.size(); i += 1) {
-				_compose(document->children[i], _content);
+				_compose(document->children[i], sink);
 			}
 		}
-
-		return std::string_view(_content.data(), _content.size());
-	}
-
-	std::string_view composeToc(Document* document) {
-		_composeToc(document);
-		return std::string_view(_toc.data(), _toc.size());
 	}
 
-private:
-	void _composeToc(const Node* node) {
-		switch (node->kind) {
-			case NodeKind::heading: {
-				auto heading = static_cast<const Heading*>(node);
+	void _composeToc(const Node* node, Sink& content) {
+		_walker.walk(node, [this, &content](const Node* node, size_t) {
+			switch (node->kind) {
+				case NodeKind::heading: {
+					auto heading = static_cast<const Heading*>(node);
+
+					switch (heading->type) {
+						case Heading::Type::chapter:
+							content.append("<ul class=\"section\">\n");
+							break;
+						case Heading::Type::section:
+							content.append("<ul class=\"subsection\">\n");
+							break;
+						case Heading::Type::subsection:
+							content.append("<ul class=\"subsubsection\">\n");
+							break;
+					}
 
-				switch (heading->type) {
-					case Heading::Type::chapter:
-						_toc.append("<ul class=\"section\">\n");
-						break;
-					case Heading::Type::section:
-						_toc.append("<ul class=\"subsection\">\n");
-						break;
-					case Heading::Type::subsection:
-						_toc.append("<ul class=\"subsubsection\">\n");
-						break;
+					return true;
 				}
+				case NodeKind::title: {
+					content.append("<li>");
 
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					_composeToc(node->children[i]);
-				}
+					content.append("<a href=\"#");
 
-				_toc.append("</ul>\n");
-				break;
-			}
-			case NodeKind::title: {
-				_toc.append("<li>");
+					_escapeID(node, content);
 
-				_toc.append("<a href=\"#");
+					content.append("\">");
 
-				_escapeID(node, _toc);
+					for (size_t i = 0; i < node->children.size(); i += 1) {
+						_compose(node->children[i], content);
+					}
 
-				_toc.append("\">");
+					content.append("</a>");
 
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					_compose(node->children[i], _toc);
+					content.append("</li>\n");
+					return false;
 				}
-
-				_toc.append("</a>");
-
-				_toc.append("</li>\n");
-				break;
-			}
-			default: {
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					_composeToc(node->children[i]);
+				default: {
+					return true;
 				}
-				break;
 			}
-		}
+		}, [this, &content](const Node* node) {
+			if (node->kind == NodeKind::heading) {
+				content.append("</ul>\n");
+			}
+		});
 	}
 
-	void _composeFootnote() {
+	void _composeFootnote(Sink& content) {
 		if (_footnotes.size() != 0) {
-			_content.append("<div class=\"footnote-desc\">\n");
+			content.append("<div class=\"footnote-desc\">\n");
 			for (size_t i = 0; i < _footnotes.size(); i += 1) {
 				const Footnote* footnote = _footnotes[i];
 
-				_content.append("<p>");
-				_content.append("<sup>");
-				_content.append(std::to_string(i + 1));
-				_content.append("</sup> ");
-				_content.append(footnote->desc.data(), footnote->desc.size());
-				_content.append("</p>\n");
+				content.append("<p>");
+				content.append("<sup>");
+				content.append(std::to_string(i + 1));
+				content.append("</sup> ");
+				content.append(footnote->desc.data(), footnote->desc.size());
+				content.append("</p>\n");
 			}
-			_content.append("</div>\n");
+			content.append("</div>\n");
 
 			_footnotes.clear();
 		}
 	}
 	void _collectReferences(const Node* node) {
-		if (node->kind == NodeKind::reference) {
-			const Reference* ref = static_cast<const Reference*>(node);
-			auto& refTable = _references[ref->id];
+		_walker.walk(node, [this](const Node* node, size_t) {
+			if (node->kind == NodeKind::reference) {
+				const Reference* ref = static_cast<const Reference*>(node);
+				auto& refTable = _references[ref->id];
 
-			for (size_t i = 0; i < ref->children.size(); i += 1) {
-				const ReferenceInfo* info = static_cast<const ReferenceInfo*>(ref->children[i]);
-				refTable[info->key] = info;
+				for (size_t i = 0; i < ref->children.size(); i += 1) {
+					const ReferenceInfo* info = static_cast<const ReferenceInfo*>(ref->children[i]);
+					refTable[info->key] = info;
+				}
+
+				return false;
 			}
 
-			return;
-		}
+			return true;
+		}, [](const Node*) {
+		});
+	}
 
-		for (size_t i = 0; i < node->children.size(); i += 1) {
-			_collectReferences(node->children[i]);
-		}
+	void _compose(const Node* node, Sink& content) {
+		_walker.walk(node, [this, &content](const Node* node, size_t) {
+			_preCompose(node, content);
+
+			if (_tocSink != nullptr && (node->kind == NodeKind::heading || node->kind == NodeKind::title)) {
+				return _preComposeToc(node, content);
+			}
+
+			return node->kind != NodeKind::reference;
+		}, [this, &content](const Node* node) {
+			if (_tocSink != nullptr && node->kind == NodeKind::heading) {
+				_tocSink->append("</ul>\n");
+			}
+
+			_postCompose(node, content);
+		});
 	}
 
-	void _compose(const Node* node, std::string& content) {
-		_preCompose(node, content);
+	// What _composeToc() writes for a heading or a title, written along with the content.
+	// The children of a title are composed into a buffer once and copied to both sinks,
+	// so that a footnote in a title is counted once.
+	bool _preComposeToc(const Node* node, Sink& content) {
+		Sink& toc = *_tocSink;
 
-		if (node->kind == NodeKind::reference) {
-			return;
+		if (node->kind == NodeKind::heading) {
+			switch (static_cast<const Heading*>(node)->type) {
+				case Heading::Type::chapter:
+					toc.append("<ul class=\"section\">\n");
+					break;
+				case Heading::Type::section:
+					toc.append("<ul class=\"subsection\">\n");
+					break;
+				case Heading::Type::subsection:
+					toc.append("<ul class=\"subsubsection\">\n");
+					break;
+			}
+
+			return true;
 		}
 
+		_title.clear();
+		_tocSink = nullptr;
+
 		for (size_t i = 0; i < node->children.size(); i += 1) {
-			_compose(node->children[i], content);
+			_compose(node->children[i], _title);
 		}
 
+		_tocSink = &toc;
+		content.append(_title.view());
+		toc.append("<li>");
+		toc.append("<a href=\"#");
+		_escapeID(node, toc);
+		toc.append("\">");
+		toc.append(_title.view());
+		toc.append("</a>");
+		toc.append("</li>\n");
 		_postCompose(node, content);
+
+		return false;
 	}
 
-	void _preCompose(const Node* node, std::string& content) {
+	void _preCompose(const Node* node, Sink& content) {
 		switch (node->kind) {
 			case NodeKind::text: {
 				const Text* text = static_cast<const Text*>(node);
@@ -202,7 +301,7 @@ private:
 						content.append("\"");
 						break;
 				}
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">");
 				return;
 			}
@@ -214,7 +313,7 @@ private:
 
 			case NodeKind::paragraph: {
 				content.append("<p");
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">");
 				return;
 			}
@@ -230,49 +329,49 @@ private:
 			}
 
 			case NodeKind::pageBreak: {
-				_composeFootnote();
+				_composeFootnote(content);
 				content.append("<div class=\"page-break\"></div>\n\n");
 				return;
 			}
 
 			case NodeKind::dinkus: {
 				content.append("<hr");
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">\n\n");
 				return;
 			}
 
 			case NodeKind::quote: {
 				content.append("<blockquote");
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">\n");
 				return;
 			}
 
 			case NodeKind::list: {
 				content.append("<ul");
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">\n");
 				return;
 			}
 
 			case NodeKind::numberedList: {
 				content.append("<ol");
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">\n");
 				return;
 			}
 
 			case NodeKind::checkList: {
 				content.append("<ul class=\"check-list");
-				_composeInnerAnnotations(node->annotations);
+				_composeInnerAnnotations(node->annotations, content);
 				content.append("\">\n");
 				return;
 			}
 
 			case NodeKind::definitionList: {
 				content.append("<dl");
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">\n");
 				return;
 			}
@@ -306,7 +405,7 @@ private:
 				const Table* table = static_cast<const Table*>(node);
 				_tableAlignments = &table->alignments;
 				content.append("<table");
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">\n");
 				return;
 			}
@@ -331,7 +430,7 @@ private:
 
 			case NodeKind::cell: {
 				if (_tableColumnIndex < _tableAlignments->size()) {
-					Table::Alignment alignment = _tableAlignments->at(_tableColumnIndex);
+					Table::Alignment alignment = (*_tableAlignments)[_tableColumnIndex];
 					_tableColumnIndex += 1;
 
 					switch (alignment) {
@@ -370,7 +469,7 @@ private:
 				if (code->label.size() != 0) {
 					content.append("<pre><code class=\"language-");
 					_escapeAttribute(code->label, content);
-					_composeInnerAnnotations(node->annotations);
+					_composeInnerAnnotations(node->annotations, content);
 					content.append("\">");
 					_escape(code->content, content);
 					content.append("</code></pre>\n\n");
@@ -378,7 +477,7 @@ private:
 				}
 
 				content.append("<pre><code");
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">");
 				_escape(code->content, content);
 				content.append("</code></pre>\n\n");
@@ -427,7 +526,7 @@ private:
 						if (extension == "jpg" || extension == "jpeg" || extension == "png" || extension == "gif") {
 							if (view->label.size() != 0) {
 								content.append("<figure");
-								_composeAnnotations(node->annotations);
+								_composeAnnotations(node->annotations, content);
 								content.append(">");
 								content.append("<img src=\"");
 								_escapeAttribute(view->resource, content);
@@ -442,7 +541,7 @@ private:
 							content.append("<img src=\"");
 							_escapeAttribute(view->resource, content);
 							content.append("\"");
-							_composeAnnotations(node->annotations);
+							_composeAnnotations(node->annotations, content);
 							content.append(">");
 							return;
 						}
@@ -453,7 +552,7 @@ private:
 				content.append("<a href=\"");
 				_escapeAttribute(view->resource, content);
 				content.append("\"");
-				_composeAnnotations(node->annotations);
+				_composeAnnotations(node->annotations, content);
 				content.append(">");
 
 				if (view->label.size() == 0) {
@@ -490,7 +589,7 @@ private:
 			case NodeKind::reference: {
 				const Reference* ref = static_cast<const Reference*>(node);
 				content.append("<div class=\"reference");
-				_composeInnerAnnotations(node->annotations);
+				_composeInnerAnnotations(node->annotations, content);
 				content.append("\" id=\"Reference-");
 				_escapeID(ref->id, content);
 				content.append("\">");
@@ -503,7 +602,7 @@ private:
 				const Admonition* ref = static_cast<const Admonition*>(node);
 				content.append("<div class=\"admonition ");
 				_escapeClass(ref->label, content);
-				_composeInnerAnnotations(node->annotations);
+				_composeInnerAnnotations(node->annotations, content);
 				content.append("\">\n");
 				content.append("<div class=\"label\">");
 				_escape(ref->label, content);
@@ -531,7 +630,7 @@ private:
 
 			case NodeKind::emoji: {
 				const Emoji* emoji = static_cast<const Emoji*>(node);
-				_content.append(_emojiConverter.convert(emoji->code));
+				content.append(_emojiConverter.convert(emoji->code));
 				return;
 			}
 
@@ -569,7 +668,7 @@ private:
 		}
 	}
 
-	void _postCompose(const Node* node, std::string& content) {
+	void _postCompose(const Node* node, Sink& content) {
 		switch (node->kind) {
 			case NodeKind::emphasis: {
 				switch (static_cast<const Emphasis*>(node)->type) {
@@ -592,7 +691,7 @@ private:
 			}
 
 			case NodeKind::heading: {
-				_composeFootnote();
+				_composeFootnote(content);
 				content.append("</section>\n"); return;
 
 				_currentHeadingType = _previousHeadingType;
@@ -685,130 +784,77 @@ private:
 		}
 	}
 
-	void _composeAnnotations(const std::vector<Pair>& annotations) {
+	void _composeAnnotations(const ArenaVector<Pair>& annotations, Sink& content) {
 		if (!annotations.empty()) {
-			_content.append(" class=\"");
+			content.append(" class=\"");
 			for (size_t i = 0; i < annotations.size(); i += 1) {
 				if (i != 0) {
-					_content.append(" ");
+					content.append(" ");
 				}
-				_escapeClass(annotations[i].key, _content);
-				_content.append("--");
-				_escapeClass(annotations[i].value, _content);
+				_escapeClass(annotations[i].key, content);
+				content.append("--");
+				_escapeClass(annotations[i].value, content);
 			}
-			_content.append("\"");
+			content.append("\"");
 		}
 	}
 
-	void _composeInnerAnnotations(const std::vector<Pair>& annotations) {
+	void _composeInnerAnnotations(const ArenaVector<Pair>& annotations, Sink& content) {
 		for (size_t i = 0; i < annotations.size(); i += 1) {
-			_content.append(" ");
-			_escapeClass(annotations[i].key, _content);
-			_content.append("--");
-			_escapeClass(annotations[i].value, _content);
+			content.append(" ");
+			_escapeClass(annotations[i].key, content);
+			content.append("--");
+			_escapeClass(annotations[i].value, content);
 		}
 	}
 
-	void _escape(std::string_view in, std::string& content) {
-		for (size_t i = 0; i < in.size(); i += 1) {
-			switch (in[i]) {
-				case '<': content.append("&lt;"); break;
-				case '>': content.append("&gt;"); break;
-				case '&': content.append("&amp;"); break;
-				case '\"': content.append("&quot;"); break;
-				case '\'': content.append("&#39;"); break;
-				default: content.append(1, in[i]); break;
-			}
-		}
+	void _escape(std::string_view in, Sink& content) {
+		Escaper::escape(in, content);
 	}
 
-	void _escapeAttribute(std::string_view in, std::string& content) {
-		for (size_t i = 0; i < in.size(); i += 1) {
-			switch (in[i]) {
-				case '\"': content.append("&quot;"); break;
-				case '\'': content.append("&#39;"); break;
-				default: content.append(1, in[i]); break;
-			}
-		}
+	void _escapeAttribute(std::string_view in, Sink& content) {
+		Escaper::escapeAttribute(in, content);
 	}
 
-	void _escapeID(std::string_view in, std::string& content) {
+	void _escapeID(std::string_view in, Sink& content) {
 		for (size_t i = 0; i < in.size(); i += 1) {
-			switch (in[i]) {
-				case '0': case '1': case '2': case '3': case '4':
-				case '5': case '6': case '7': case '8': case '9':
-
-				case 'A': case 'B': case 'C': case 'D': case 'E': case 'F': case 'G':
-				case 'H': case 'I': case 'J': case 'K': case 'L': case 'M':
-				case 'N': case 'O': case 'P': case 'Q': case 'R': case 'S': case 'T': 
-				case 'U': case 'V': case 'W': case 'X': case 'Y': case 'Z':
-
-				case 'a': case 'b': case 'c': case 'd': case 'e': case 'f': case 'g':
-				case 'h': case 'i': case 'j': case 'k': case 'l': case 'm':
-				case 'n': case 'o': case 'p': case 'q': case 'r': case 's': case 't': 
-				case 'u': case 'v': case 'w': case 'x': case 'y': case 'z':
-					content.append(1, in[i]);
-					break;
-
-				case '-':
-				case ' ': 
-					content.append(1, '-'); 
-					break;
+			if (CharClass::isAlphanumeric(in[i])) {
+				content.append(1, in[i]);
+				continue;
+			}
 
-				default: 
-					break;
+			if (in[i] == '-' || in[i] == ' ') {
+				content.append(1, '-');
 			}
 		}
 	}
 
-	void _escapeClass(std::string_view in, std::string& content) {
+	void _escapeClass(std::string_view in, Sink& content) {
 		for (size_t i = 0; i < in.size(); i += 1) {
-			switch (in[i]) {
-				case '0': case '1': case '2': case '3': case '4':
-				case '5': case '6': case '7': case '8': case '9':
-					content.append(1, in[i]);
-					break;
-
-				case 'A': case 'B': case 'C': case 'D': case 'E': case 'F': case 'G':
-				case 'H': case 'I': case 'J': case 'K': case 'L': case 'M':
-				case 'N': case 'O': case 'P': case 'Q': case 'R': case 'S': case 'T': 
-				case 'U': case 'V': case 'W': case 'X': case 'Y': case 'Z':
-					content.append(1, in[i] + ' ');
-					break;
-
-				case 'a': case 'b': case 'c': case 'd': case 'e': case 'f': case 'g':
-				case 'h': case 'i': case 'j': case 'k': case 'l': case 'm':
-				case 'n': case 'o': case 'p': case 'q': case 'r': case 's': case 't': 
-				case 'u': case 'v': case 'w': case 'x': case 'y': case 'z':
-					content.append(1, in[i]);
-					break;
-
-				case '-':
-				case ' ': 
-					content.append(1, '-'); 
-					break;
+			if (CharClass::isAlphanumeric(in[i])) {
+				// lowercase, digits are unaffected by the case bit
+				content.append(1, in[i] | 0x20);
+				continue;
+			}
 
-				default: 
-					break;
+			if (in[i] == '-' || in[i] == ' ') {
+				content.append(1, '-');
 			}
 		}
 	}
 
-	void _escapeID(const Node* node, std::string& content) {
-		if (node->kind == NodeKind::text) {
-			_escapeID(static_cast<const Text*>(node)->content, content);
-		}
-
-		if (node->kind == NodeKind::subtitle) {
-			return;
-		}
+	void _escapeID(const Node* node, Sink& content) {
+		_walker.walk(node, [this, &content](const Node* node, size_t) {
+			if (node->kind == NodeKind::text) {
+				_escapeID(static_cast<const Text*>(node)->content, content);
+			}
 
-		for (size_t i = 0; i < node->children.size(); i += 1) {
-			_escapeID(node->children[i], content);
-		}
+			return node->kind != NodeKind::subtitle;
+		}, [](const Node*) {
+		});
 	}
 
-	void _inText(std::string_view id, std::string& content) {
+	void _inText(std::string_view id, Sink& content) {
 		// APA Style:
 		// Single author
 		// (Author last name, the year of publication)
@@ -829,18 +875,18 @@ private:
 
 		content.append("(");
 		if (table.count("author")) {
-			std::string author;
+			StringSink author;
 			_compose(table["author"], author);
 
-			std::vector<std::string_view> nameParts = _splitName(author);
+			std::vector<std::string_view> nameParts = _splitName(author.view());
 			std::string_view lastName = nameParts.back();
 			content.append(lastName.data(), lastName.size());
 		}
 		if (table.count("authors")) {
-			std::string authors;
+			StringSink authors;
 			_compose(table["authors"], authors);
 
-			std::vector<std::string_view> names = _splitByComma(authors);
+			std::vector<std::string_view> names = _splitByComma(authors.view());
 			if (names.size() == 2) {
 				std::vector<std::string_view> nameParts0 = _splitName(names[0]);
 				std::string_view lastName0 = nameParts0.back();
@@ -858,16 +904,16 @@ private:
 			}
 		}
 		if (table.count("year")) {
-			std::string year;
+			StringSink year;
 			_compose(table["year"], year);
 
 			content.append(", ");
-			content.append(Helper::trim(year));
+			content.append(Helper::trim(year.view()));
 		}
 		content.append(")");
 	}
 
-	void _reference(std::string_view id, std::string& content) {
+	void _reference(std::string_view id, Sink& content) {
 		// APA Style:
 		// Author’s Last Name, First Initial. Second Initial. (Year of publication). <i>Title of the book</i>. Publishing Company. 
 
@@ -878,18 +924,18 @@ private:
 		auto table = _references[id];
 
 		if (table.count("author")) {
-			std::string author;
+			StringSink author;
 			_compose(table["author"], author);
 
-			std::vector<std::string_view> nameParts = _splitName(author);
+			std::vector<std::string_view> nameParts = _splitName(author.view());
 			_composeLastNameInitials(nameParts, content);
 			content.append(",");
 		}
 		if (table.count("authors")) {
-			std::string authors;
+			StringSink authors;
 			_compose(table["authors"], authors);
 
-			std::vector<std::string_view> names = _splitByComma(authors);
+			std::vector<std::string_view> names = _splitByComma(authors.view());
 			if (names.size() > 1) {
 				for (size_t i = 0; i < names.size() - 1; i += 1) {
 					if (i != 0) {
@@ -905,32 +951,32 @@ private:
 			_composeLastNameInitials(nameParts, content);
 		}
 		if (table.count("year")) {
-			std::string year;
+			StringSink year;
 			_compose(table["year"], year);
 
 			content.append(" (");
-			content.append(Helper::trim(year));
+			content.append(Helper::trim(year.view()));
 			content.append(").");
 		}
 		if (table.count("title")) {
-			std::string title;
+			StringSink title;
 			_compose(table["title"], title);
 
 			content.append(" <i>");
-			content.append(Helper::trim(title));
+			content.append(Helper::trim(title.view()));
 			content.append("</i>.");
 		}
 		if (table.count("publisher")) {
-			std::string publisher;
+			StringSink publisher;
 			_compose(table["publisher"], publisher);
 
 			content.append(" ");
-			content.append(Helper::trim(publisher));
+			content.append(Helper::trim(publisher.view()));
 			content.append(".");
 		}
 	}
 
-	void _composeLastNameInitials(std::vector<std::string_view>& nameParts, std::string& content) {
+	void _composeLastNameInitials(std::vector<std::string_view>& nameParts, Sink& content) {
 		if (nameParts.size() == 0) {
 			return;
 		}
@@ -1005,11 +1051,18 @@ private:
 	}
 
 private:
-	std::string _toc;
+	StringSink _toc;
+
+	// the children of the last title, while the table of contents is composed along with the content
+	StringSink _title;
 
-	std::string _content;
+	Sink* _tocSink;
 
-	const std::vector<Table::Alignment>* _tableAlignments;
+	StringSink _content;
+
+	size_t _estimatedSize;
+
+	const ArenaVector<Table::Alignment>* _tableAlignments;
 
 	size_t _tableColumnIndex;
 
@@ -1024,6 +1077,8 @@ private:
 	Heading::Type _currentHeadingType;
 
 	EmojiConverter _emojiConverter;
+
+	NodeWalker _walker;
 };
 
 }
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "Gularen/Library/Scanner.hpp"
+#include "Gularen/Library/Sink.hpp"
+
+namespace Gularen {
+namespace Html {
+
+// Escapes text for HTML.
+// The kernels look for the next byte that needs an entity, the runs in between are
+// copied to the sink as they are. Text escapes < > & " and ', an attribute only " and '.
+// The kernels are the ones of the scanner, picked the same way.
+class Escaper {
+public:
+	using Kernel = Scanner::Kernel;
+
+	static void escape(std::string_view content, Sink& sink) {
+		_escape(content, sink, false);
+	}
+
+	static void escapeAttribute(std::string_view content, Sink& sink) {
+		_escape(content, sink, true);
+	}
+
+	static bool isSupported(Kernel kernel) {
+		return Scanner::isSupported(kernel);
+	}
+
+	// The widest supported kernel is picked on first use, this is only meant for benchmarks and tests.
+	static void setKernel(Kernel kernel) {
+		if (isSupported(kernel)) {
+			_kernel() = kernel;
+			_function() = _select(kernel);
+		}
+	}
+
+	static Kernel kernel() {
+		_function();
+		return _kernel();
+	}
+
+private:
+	using Function = size_t (*)(const char* data, size_t size, size_t index, bool attribute);
+
+	static void _escape(std::string_view content, Sink& sink, bool attribute) {
+		Function find = _function();
+		size_t index = 0;
+
+		while (index < content.size()) {
+			size_t special = find(content.data(), content.size(), index, attribute);
+			sink.append(content.data() + index, special - index);
+
+			if (special == content.size()) {
+				return;
+			}
+
+			switch (content[special]) {
+				case '<': sink.append("&lt;"); break;
+				case '>': sink.append("&gt;"); break;
+				case '&': sink.append("&amp;"); break;
+				case '\"': sink.append("&quot;"); break;
+				case '\'': sink.append("&#39;"); break;
+			}
+
+			index = special + 1;
+		}
+	}
+
+	static Kernel& _kernel() {
+		static Kernel kernel = isSupported(Kernel::avx2) ? Kernel::avx2 : isSupported(Kernel::sse2) ? Kernel::sse2 : Kernel::scalar;
+		return kernel;
+	}
+
+	static Function& _function() {
+		static Function function = _select(_kernel());
+		return function;
+	}
+
+	static Function _select(Kernel kernel) {
+		switch (kernel) {
+			#ifdef GULAREN_SCANNER_AVX2
+			case Kernel::avx2: return _findAvx2;
+			#endif
+
+			#ifdef GULAREN_SCANNER_SSE2
+			case Kernel::sse2: return _findSse2;
+			#endif
+
+			default: return _findScalar;
+		}
+	}
+
+	// Returns the index of the next byte that needs an entity, or size when there is none.
+	static size_t _findScalar(const char* data, size_t size, size_t index, bool attribute) {
+		while (index < size) {
+			char byte = data[index];
+
+			if (byte == '\"' || byte == '\'' || (!attribute && (byte == '<' || byte == '>' || byte == '&'))) {
+				return index;
+			}
+
+			index += 1;
+		}
+
+		return index;
+	}
+
+	#ifdef GULAREN_SCANNER_SSE2
+	static size_t _findSse2(const char* data, size_t size, size_t index, bool attribute) {
+		const __m128i quote = _mm_set1_epi8('\"');
+		const __m128i apostrophe = _mm_set1_epi8('\'');
+		const __m128i less = _mm_set1_epi8('<');
+		const __m128i greater = _mm_set1_epi8('>');
+		const __m128i ampersand = _mm_set1_epi8('&');
+
+		while (index + 16 <= size) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+			__m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, apostrophe));
+
+			if (!attribute) {
+				special = _mm_or_si128(
+					special,
+					_mm_or_si128(_mm_cmpeq_epi8(chunk, less), _mm_or_si128(_mm_cmpeq_epi8(chunk, greater), _mm_cmpeq_epi8(chunk, ampersand)))
+				);
+			}
+
+			unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(special));
+
+			if (mask != 0) {
+				return index + __builtin_ctz(mask);
+			}
+
+			index += 16;
+		}
+
+		return _findScalar(data, size, index, attribute);
+	}
+	#endif
+
+	#ifdef GULAREN_SCANNER_AVX2
+	__attribute__((target("avx2")))
+	static size_t _findAvx2(const char* data, size_t size, size_t index, bool attribute) {
+		const __m256i quote = _mm256_set1_epi8('\"');
+		const __m256i apostrophe = _mm256_set1_epi8('\'');
+		const __m256i less = _mm256_set1_epi8('<');
+		const __m256i greater = _mm256_set1_epi8('>');
+		const __m256i ampersand = _mm256_set1_epi8('&');
+
+		while (index + 32 <= size) {
+			__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+			__m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, apostrophe));
+
+			if (!attribute) {
+				special = _mm256_or_si256(
+					special,
+					_mm256_or_si256(_mm256_cmpeq_epi8(chunk, less), _mm256_or_si256(_mm256_cmpeq_epi8(chunk, greater), _mm256_cmpeq_epi8(chunk, ampersand)))
+				);
+			}
+
+			unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(special));
+
+			if (mask != 0) {
+				return index + __builtin_ctz(mask);
+			}
+
+			index += 32;
+		}
+
+		return _findSse2(data, size, index, attribute);
+	}
+	#endif
+};
+
+}
+}
@@ -1,8 +1,7 @@
 #pragma once
 
 #include "Gularen/Backend/Html/Composer.hpp"
-#include <fstream>
-#include <filesystem>
+#include "Gularen/Library/FileBuffer.hpp"
 
 namespace Gularen {
 namespace Html {
@@ -10,6 +9,8 @@ namespace Html {
 class TemplateManager {
 public:
 	TemplateManager() {
+		_document = nullptr;
+		_deferred = Part::none;
 	}
 
 	void setDocument(Document* document) {
@@ -22,14 +23,22 @@ public:
 	}
 
 	void setTemplateFile(const std::string_view path) {
-		std::ifstream file;
-		file.open(std::string(path));
-		_templateContent.assign(std::filesystem::file_size(path), '\0');
-		file.read(_templateContent.data(), _templateContent.size());
+		_templateFile.open(path);
+		_templateContent = _templateFile.view();
 	}
 
 	std::string_view render() {
+		_content.clear();
+		_content.reserve(_templateContent.size() + Composer::estimate(_document));
+		render(_content);
+
+		return _content.view();
+	}
+
+	// Writes the output to the sink as it is rendered, the sink is not flushed.
+	void render(Sink& sink) {
 		_templateIndex = 0;
+		_deferred = Part::none;
 
 		while (_isBound(0)) {
 			if (_get(0) == '<' && _isBound(4) &&
@@ -68,17 +77,13 @@ public:
 					if (annotation) {
 						if (_documentAnnotations.count(key)) {
 							std::string_view value = _documentAnnotations[key];
-							_escape(value);
+							Escaper::escape(value, sink);
 						}
 					} else {
 						if (key == "content") {
-							Composer composer;
-							std::string_view content = composer.compose(_document);
-							_content.append(content.data(), content.size());
+							_renderContent(sink);
 						} else if (key == "toc") {
-							Composer composer;
-							std::string_view content = composer.composeToc(_document);
-							_content.append(content.data(), content.size());
+							_renderToc(sink);
 						}
 					}
 				}
@@ -86,14 +91,53 @@ public:
 				continue;
 			}
 
-			_content.push_back(_get(0));
+			sink.push_back(_get(0));
 			_advance(1);
 		}
-
-		return std::string_view(_content.data(), _content.size());
 	}
 
 private:
+	enum class Part {
+		none,
+		content,
+		toc,
+	};
+
+	// The content and the table of contents come out of one pass of the composer. The part reached
+	// first in the template is written to the sink, the other one is kept until it is reached.
+	void _renderContent(Sink& sink) {
+		if (_deferred == Part::content) {
+			sink.append(_deferredOutput.view());
+			return;
+		}
+
+		if (_templateContent.find("<!--[toc]", _templateIndex) != std::string_view::npos) {
+			_deferredOutput.clear();
+			_composer.compose(_document, sink, _deferredOutput);
+			_deferred = Part::toc;
+			return;
+		}
+
+		_composer.compose(_document, sink);
+	}
+
+	void _renderToc(Sink& sink) {
+		if (_deferred == Part::toc) {
+			sink.append(_deferredOutput.view());
+			return;
+		}
+
+		if (_templateContent.find("<!--[content]", _templateIndex) != std::string_view::npos) {
+			_deferredOutput.clear();
+			_deferredOutput.reserve(Composer::estimate(_document));
+			_composer.compose(_document, _deferredOutput, sink);
+			_deferred = Part::content;
+			return;
+		}
+
+		_composer.composeToc(_document, sink);
+	}
+
 	bool _isBound(size_t offset) {
 		return _templateIndex + offset < _templateContent.size();
 	}
@@ -106,21 +150,10 @@ private:
 		_templateIndex += offset;
 	}
 
-	void _escape(std::string_view in) {
-		for (size_t i = 0; i < in.size(); i += 1) {
-			switch (in[i]) {
-				case '<': _content.append("&lt;"); break;
-				case '>': _content.append("&gt;"); break;
-				case '&': _content.append("&amp;"); break;
-				case '\"': _content.append("&quot;"); break;
-				case '\'': _content.append("&#39;"); break;
-				default: _content.append(1, in[i]); break;
-			}
-		}
-	}
-
 private:
-	std::string _templateContent;
+	FileBuffer _templateFile;
+
+	std::string_view _templateContent;
 
 	size_t _templateIndex;
 
@@ -128,7 +161,14 @@ private:
 
 	Document* _document;
 
-	std::string _content;
+	StringSink _content;
+
+	Composer _composer;
+
+	// the part of the last render that is not written yet
+	Part _deferred;
+
+	StringSink _deferredOutput;
 };
 
 }
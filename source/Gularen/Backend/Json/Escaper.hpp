@@ -0,0 +1,241 @@
+#pragma once
+
+#include "Gularen/Library/Scanner.hpp"
+#include "Gularen/Library/Sink.hpp"
+
+namespace Gularen {
+namespace Json {
+
+// Escapes the content of a JSON string.
+// The kernels look for the next byte that is not printable ASCII or is one of " \ and /,
+// the runs in between are copied to the sink as they are. A well-formed UTF-8 sequence is
+// kept as it is, a byte that does not belong to one is written as \uFFFD, the replacement
+// character, so the output is valid UTF-8 whatever the input. Control bytes and DEL are \u00XX.
+// The kernels are the ones of the scanner, picked the same way.
+class Escaper {
+public:
+	using Kernel = Scanner::Kernel;
+
+	static void escape(std::string_view content, Sink& sink) {
+		Function find = _function();
+		const char* data = content.data();
+		size_t size = content.size();
+		size_t begin = 0;
+		size_t index = 0;
+
+		while (index < size) {
+			index = find(data, size, index);
+
+			if (index == size) {
+				break;
+			}
+
+			unsigned char byte = data[index];
+
+			if (byte >= 0x80) {
+				size_t length = _sequenceLength(data, size, index);
+
+				if (length != 0) {
+					index += length;
+					continue;
+				}
+			}
+
+			sink.append(data + begin, index - begin);
+			_escapeByte(byte, sink);
+			index += 1;
+			begin = index;
+		}
+
+		sink.append(data + begin, size - begin);
+	}
+
+	static bool isSupported(Kernel kernel) {
+		return Scanner::isSupported(kernel);
+	}
+
+	// The widest supported kernel is picked on first use, this is only meant for benchmarks and tests.
+	static void setKernel(Kernel kernel) {
+		if (isSupported(kernel)) {
+			_kernel() = kernel;
+			_function() = _select(kernel);
+		}
+	}
+
+	static Kernel kernel() {
+		_function();
+		return _kernel();
+	}
+
+private:
+	using Function = size_t (*)(const char* data, size_t size, size_t index);
+
+	static void _escapeByte(unsigned char byte, Sink& sink) {
+		switch (byte) {
+			case '"': sink.append("\\\""); return;
+			case '\\': sink.append("\\\\"); return;
+			case '/': sink.append("\\/"); return;
+			case 8: sink.append("\\b"); return;
+			case 12: sink.append("\\f"); return;
+			case '\r': sink.append("\\r"); return;
+			case '\n': sink.append("\\n"); return;
+			case '\t': sink.append("\\t"); return;
+		}
+
+		// a byte of broken UTF-8
+		if (byte >= 0x80) {
+			sink.append("\\uFFFD");
+			return;
+		}
+
+		static const char* digits = "0123456789ABCDEF";
+		char escaped[6] = { '\\', 'u', '0', '0', digits[byte >> 4], digits[byte & 0x0F] };
+		sink.append(escaped, sizeof(escaped));
+	}
+
+	// The length of the well-formed UTF-8 sequence at index, 0 when there is none.
+	// Overlong forms, surrogates and code points past U+10FFFF are not well-formed.
+	static size_t _sequenceLength(const char* data, size_t size, size_t index) {
+		unsigned char byte = data[index];
+		size_t length = 0;
+		unsigned char low = 0x80;
+		unsigned char high = 0xBF;
+
+		if (byte >= 0xC2 && byte <= 0xDF) {
+			length = 2;
+		} else if (byte >= 0xE0 && byte <= 0xEF) {
+			length = 3;
+			low = byte == 0xE0 ? 0xA0 : 0x80;
+			high = byte == 0xED ? 0x9F : 0xBF;
+		} else if (byte >= 0xF0 && byte <= 0xF4) {
+			length = 4;
+			low = byte == 0xF0 ? 0x90 : 0x80;
+			high = byte == 0xF4 ? 0x8F : 0xBF;
+		} else {
+			return 0;
+		}
+
+		if (index + length > size) {
+			return 0;
+		}
+
+		// only the second byte has a narrower range
+		unsigned char second = data[index + 1];
+
+		if (second < low || second > high) {
+			return 0;
+		}
+
+		for (size_t i = 2; i < length; i += 1) {
+			unsigned char next = data[index + i];
+
+			if (next < 0x80 || next > 0xBF) {
+				return 0;
+			}
+		}
+
+		return length;
+	}
+
+	static Kernel& _kernel() {
+		static Kernel kernel = isSupported(Kernel::avx2) ? Kernel::avx2 : isSupported(Kernel::sse2) ? Kernel::sse2 : Kernel::scalar;
+		return kernel;
+	}
+
+	static Function& _function() {
+		static Function function = _select(_kernel());
+		return function;
+	}
+
+	static Function _select(Kernel kernel) {
+		switch (kernel) {
+			#ifdef GULAREN_SCANNER_AVX2
+			case Kernel::avx2: return _findAvx2;
+			#endif
+
+			#ifdef GULAREN_SCANNER_SSE2
+			case Kernel::sse2: return _findSse2;
+			#endif
+
+			default: return _findScalar;
+		}
+	}
+
+	// Returns the index of the next byte that is not copied as it is, or size when there is none.
+	static size_t _findScalar(const char* data, size_t size, size_t index) {
+		while (index < size) {
+			unsigned char byte = data[index];
+
+			if (byte < ' ' || byte > '~' || byte == '"' || byte == '\\' || byte == '/') {
+				return index;
+			}
+
+			index += 1;
+		}
+
+		return index;
+	}
+
+	#ifdef GULAREN_SCANNER_SSE2
+	static size_t _findSse2(const char* data, size_t size, size_t index) {
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i slash = _mm_set1_epi8('/');
+		const __m128i printableFirst = _mm_set1_epi8(' ');
+		const __m128i printableSpan = _mm_set1_epi8('~' - ' ');
+
+		while (index + 16 <= size) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+
+			// c - ' ' <= '~' - ' ', as an unsigned range check, catches control bytes, DEL and UTF-8 bytes
+			__m128i printable = _mm_sub_epi8(chunk, printableFirst);
+			printable = _mm_cmpeq_epi8(_mm_min_epu8(printable, printableSpan), printable);
+
+			__m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_or_si128(_mm_cmpeq_epi8(chunk, backslash), _mm_cmpeq_epi8(chunk, slash)));
+
+			unsigned int mask = (~static_cast<unsigned int>(_mm_movemask_epi8(printable)) | static_cast<unsigned int>(_mm_movemask_epi8(special))) & 0xFFFF;
+
+			if (mask != 0) {
+				return index + __builtin_ctz(mask);
+			}
+
+			index += 16;
+		}
+
+		return _findScalar(data, size, index);
+	}
+	#endif
+
+	#ifdef GULAREN_SCANNER_AVX2
+	__attribute__((target("avx2")))
+	static size_t _findAvx2(const char* data, size_t size, size_t index) {
+		const __m256i quote = _mm256_set1_epi8('"');
+		const __m256i backslash = _mm256_set1_epi8('\\');
+		const __m256i slash = _mm256_set1_epi8('/');
+		const __m256i printableFirst = _mm256_set1_epi8(' ');
+		const __m256i printableSpan = _mm256_set1_epi8('~' - ' ');
+
+		while (index + 32 <= size) {
+			__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+
+			__m256i printable = _mm256_sub_epi8(chunk, printableFirst);
+			printable = _mm256_cmpeq_epi8(_mm256_min_epu8(printable, printableSpan), printable);
+
+			__m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_or_si256(_mm256_cmpeq_epi8(chunk, backslash), _mm256_cmpeq_epi8(chunk, slash)));
+
+			unsigned int mask = ~static_cast<unsigned int>(_mm256_movemask_epi8(printable)) | static_cast<unsigned int>(_mm256_movemask_epi8(special));
+
+			if (mask != 0) {
+				return index + __builtin_ctz(mask);
+			}
+
+			index += 32;
+		}
+
+		return _findSse2(data, size, index);
+	}
+	#endif
+};
+
+}
+}
@@ -1,138 +1,242 @@
 #pragma once
 
 #include "Gularen/Frontend/Parser.hpp"
+#include "Gularen/Backend/OutputEstimate.hpp"
+#include "Gularen/Library/Sink.hpp"
 
 namespace Gularen {
 namespace Markdown {
 
 class Composer {
 public:
+	Composer() {
+		_estimatedSize = 0;
+	}
+
 	std::string_view compose(Document* document) {
-		_content = std::string();
+		_content.clear();
+		_estimatedSize = estimate(document);
+		_content.reserve(_estimatedSize);
+		compose(document, _content);
+
+		return _content.view();
+	}
+
+	// The size of the output guessed from the size hint of the document, on the large side.
+	static size_t estimate(const Document* document) {
+		if (document == nullptr) {
+			return 0;
+		}
+
+		return OutputEstimate::size(OutputEstimate::of(document), 8, 1, 16);
+	}
+
+	// How the estimate of the last compose() into memory held up.
+	OutputStats stats() const {
+		return OutputStats { _estimatedSize, _content.size(), _content.growthCount() };
+	}
+
+	// Writes the output to the sink as it is composed, the sink is not flushed.
+	void compose(Document* document, Sink& sink) {
+		_sink = &sink;
 		_listItem = false;
 		_listCount = 0;
 		_indent = 0;
 
 		if (document != nullptr) {
-			for (size_t i = 0; i < document->children.size(); i += 1) {
-				_composeBlock(document->children[i]);
+			_pushBlocks(document, 0, Close::none);
+			_run();
+		}
+	}
+
+private:
+	// what a frame does with the children it goes through
+	enum class Mode {
+		blocks,
+		inlines,
+		paragraph,
+		item,
+	};
+
+	// what a frame appends or restores when its children are done
+	enum class Close {
+		none,
+		newline,
+		paragraph,
+		indent,
+		list,
+		bold,
+		italic,
+		underline,
+	};
+
+	struct Frame {
+		const Node* node;
+		size_t next;
+		Mode mode;
+		Close close;
+
+		// the list state around a list
+		bool listItem;
+		size_t listCount;
+
+		// a paragraph line still needs its prefix
+		bool lineStart;
+	};
+
+	// The children of the nodes are composed on an explicit stack of frames instead of recursing,
+	// a block pushes a frame for its children and the frame on top is worked on until it is done.
+	void _run() {
+		while (!_frames.empty()) {
+			Frame& frame = _frames.back();
+
+			if (frame.mode == Mode::paragraph) {
+				_stepParagraph(frame);
+				continue;
+			}
+
+			if (frame.next == frame.node->children.size()) {
+				Frame done = frame;
+				_frames.pop_back();
+				_close(done);
+				continue;
+			}
+
+			const Node* node = frame.node;
+			const Node* child = node->children[frame.next];
+			frame.next += 1;
+
+			// the frame is not touched past this point, the calls below may push
+			switch (frame.mode) {
+				case Mode::blocks:
+					_composeBlock(child);
+					break;
+				case Mode::inlines:
+					_composeInline(child);
+					break;
+				case Mode::item:
+					_composeItemChild(node, child);
+					break;
+				default:
+					break;
 			}
 		}
+	}
 
-		return std::string_view(_content.data(), _content.size());
+	void _push(const Node* node, size_t next, Mode mode, Close close) {
+		_frames.push_back({ node, next, mode, close, false, 0, true });
+	}
+
+	void _pushBlocks(const Node* node, size_t next, Close close) {
+		_push(node, next, Mode::blocks, close);
+	}
+
+	void _pushInlines(const Node* node, Close close) {
+		_push(node, 0, Mode::inlines, close);
+	}
+
+	void _close(const Frame& frame) {
+		switch (frame.close) {
+			case Close::none:
+				break;
+			case Close::newline:
+				_sink->append("\n");
+				break;
+			case Close::paragraph:
+				_sink->append("\n\n");
+				break;
+			case Close::indent:
+				_indent -= 1;
+				break;
+			case Close::list:
+				if (!frame.listItem) {
+					_sink->append("\n");
+				}
+				_listItem = frame.listItem;
+				_listCount = frame.listCount;
+				break;
+			case Close::bold:
+				_sink->append("**");
+				break;
+			case Close::italic:
+				_sink->append("_");
+				break;
+			case Close::underline:
+				_sink->append("</u>");
+				break;
+		}
 	}
 
-private:
 	void _composeBlock(const Node* node) {
 		switch (node->kind) {
-			case NodeKind::paragraph: return _composeParagraph(node);
+			case NodeKind::paragraph:
+				_push(node, 0, Mode::paragraph, Close::paragraph);
+				break;
 			case NodeKind::document:
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					_composeBlock(node->children[i]);
-				}
+				_pushBlocks(node, 0, Close::none);
 				break;
 			case NodeKind::heading: {
 				switch (static_cast<const Heading*>(node)->type) {
-					case Heading::Type::chapter: _content.append("# "); break;
-					case Heading::Type::section: _content.append("## "); break;
-					case Heading::Type::subsection: _content.append("### "); break;
+					case Heading::Type::chapter: _sink->append("# "); break;
+					case Heading::Type::section: _sink->append("## "); break;
+					case Heading::Type::subsection: _sink->append("### "); break;
 					default: break;
 				}
-				for (size_t i = 0; i < node->children[0]->children.size(); i += 1) {
-					_composeInline(node->children[0]->children[i]);
-				}
-				_content.append("\n");
-				for (size_t i = 1; i < node->children.size(); i += 1) {
-					_composeBlock(node->children[i]);
-				}
+				// the title goes first, so it is pushed last
+				_pushBlocks(node, 1, Close::none);
+				_pushInlines(node->children[0], Close::newline);
 				break;
 			}
 			case NodeKind::codeBlock: {
 				const CodeBlock* block = static_cast<const CodeBlock*>(node);
-				_content.append("```");
-				_content.append(block->label.data(), block->label.size());
-				_content.append("\n");
-				_content.append(block->content.data(), block->content.size());
-				_content.append("\n```\n\n");
+				_sink->append("```");
+				_sink->append(block->label.data(), block->label.size());
+				_sink->append("\n");
+				_sink->append(block->content.data(), block->content.size());
+				_sink->append("\n```\n\n");
 				break;
 			}
 			case NodeKind::dinkus: {
-				_content.append("***\n");
+				_sink->append("***\n");
 				break;
 			}
 			case NodeKind::list:
 			case NodeKind::numberedList:
 			case NodeKind::checkList: {
-				bool prevListItem = _listItem;
-				size_t prevListCount = _listCount;
+				_pushBlocks(node, 0, Close::list);
+				_frames.back().listItem = _listItem;
+				_frames.back().listCount = _listCount;
 				_listItem = false;
 				_listCount = node->kind == NodeKind::numberedList ? 1 : 0;
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					_composeBlock(node->children[i]);
-				}
-				if (!prevListItem) {
-					_content.append("\n");
-				}
-				_listItem = prevListItem;
-				_listCount = prevListCount;
 				break;
 			}
 			case NodeKind::item: {
 				_composePrefix();
 				_listItem = true;
 				if (_listCount == 0) {
-					_content.append("- ");
+					_sink->append("- ");
 				} else {
 					std::string count = std::to_string(_listCount);
-					_content.append(count.data(), count.size());
-					_content.append(". ");
+					_sink->append(count.data(), count.size());
+					_sink->append(". ");
 					_listCount += 1;
 				}
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					if (node->children[i]->kind == NodeKind::list ||
-						node->children[i]->kind == NodeKind::numberedList ||
-						node->children[i]->kind == NodeKind::checkList) {
-						_indent += 1;
-						_content.append("\n");
-						for (size_t i = 0; i < node->children.size(); i += 1) {
-							_composeBlock(node->children[i]);
-						}
-						_indent -= 1;
-						continue;
-					}
-					_composeInline(node->children[i]);
-				}
-				_content.append("\n");
+				_push(node, 0, Mode::item, Close::newline);
 				break;
 			}
 			case NodeKind::checkItem: {
 				_composePrefix();
 				_listItem = true;
-				_content.append("- [");
-				_content.append(static_cast<const CheckItem*>(node)->checked ? " " : "x");
-				_content.append("] ");
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					if (node->children[i]->kind == NodeKind::list) {
-						_indent += 1;
-						_content.append("\n");
-						for (size_t i = 0; i < node->children.size(); i += 1) {
-							_composeBlock(node->children[i]);
-						}
-						_indent -= 1;
-						continue;
-					}
-					_composeInline(node->children[i]);
-				}
-				_content.append("\n");
+				_sink->append("- [");
+				_sink->append(static_cast<const CheckItem*>(node)->checked ? " " : "x");
+				_sink->append("] ");
+				_push(node, 0, Mode::item, Close::newline);
 				break;
 			}
 			case NodeKind::quote: {
 				_indent += 1;
-				_content.append("\n");
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					_composeBlock(node->children[i]);
-				}
-				_indent -= 1;
+				_sink->append("\n");
+				_pushBlocks(node, 0, Close::indent);
 				break;
 			}
 			default: {
@@ -141,154 +245,168 @@ private:
 		}
 	}
 
+	// a nested list in an item composes every child of the item as a block, the ones before it too
+	void _composeItemChild(const Node* item, const Node* child) {
+		bool nestedList = child->kind == NodeKind::list;
+
+		if (item->kind == NodeKind::item) {
+			nestedList = nestedList || child->kind == NodeKind::numberedList || child->kind == NodeKind::checkList;
+		}
+
+		if (nestedList) {
+			_indent += 1;
+			_sink->append("\n");
+			_pushBlocks(item, 0, Close::indent);
+			return;
+		}
+
+		_composeInline(child);
+	}
+
 	void _composePrefix() {
 		for (size_t i = 0; i < _indent; i += 1) {
-			_content.append("\t");
+			_sink->append("\t");
 		}
 	}
 
-	void _composeParagraph(const Node* node) {
-		size_t i = 0;
-		while (i < node->children.size()) {
+	// a space ends a line of the paragraph, the next line starts with the prefix again
+	void _stepParagraph(Frame& frame) {
+		const Node* node = frame.node;
+
+		if (frame.next >= node->children.size()) {
+			Frame done = frame;
+			_frames.pop_back();
+			_close(done);
+			return;
+		}
+
+		if (frame.lineStart) {
 			_composePrefix();
+			frame.lineStart = false;
+		}
 
-			while (i < node->children.size()) {
-				if (node->children[i]->kind == NodeKind::space) {
-					_content.append("\n");
-					break;
-				}
-				_composeInline(node->children[i]);
-				i += 1;
-			}
-			i += 1;
+		const Node* child = node->children[frame.next];
+		frame.next += 1;
+
+		if (child->kind == NodeKind::space) {
+			_sink->append("\n");
+			frame.lineStart = true;
+			return;
 		}
-		_content.append("\n\n");
+
+		_composeInline(child);
 	}
 
 	void _composeInline(const Node* node) {
 		switch (node->kind) {
 			case NodeKind::text: {
 				std::string_view content = static_cast<const Text*>(node)->content;
-				_content.append(content.data(), content.size());
+				_sink->append(content.data(), content.size());
 				break;
 			}
 			case NodeKind::emphasis: {
 				switch (static_cast<const Emphasis*>(node)->type) {
 					case Emphasis::Type::bold: {
-						_content.append("**");
-						for (size_t i = 0; i < node->children.size(); i += 1) {
-							_composeInline(node->children[i]);
-						}
-						_content.append("**");
+						_sink->append("**");
+						_pushInlines(node, Close::bold);
 						break;
 					}
 					case Emphasis::Type::italic: {
-						_content.append("_");
-						for (size_t i = 0; i < node->children.size(); i += 1) {
-							_composeInline(node->children[i]);
-						}
-						_content.append("_");
+						_sink->append("_");
+						_pushInlines(node, Close::italic);
 						break;
 					}
 					case Emphasis::Type::underline: {
-						_content.append("<u>");
-						for (size_t i = 0; i < node->children.size(); i += 1) {
-							_composeInline(node->children[i]);
-						}
-						_content.append("</u>");
+						_sink->append("<u>");
+						_pushInlines(node, Close::underline);
 						break;
 					}
 				}
 				break;
 			}
 			case NodeKind::lineBreak: {
-				_content.append("  \n");
+				_sink->append("  \n");
 				break;
 			}
 			case NodeKind::punct: {
 				switch (static_cast<const Punct*>(node)->type) {
-					case Punct::Type::quoteOpen: _content.append("“"); break;
-					case Punct::Type::quoteClose: _content.append("”"); break;
-					case Punct::Type::squoteOpen: _content.append("‘"); break;
-					case Punct::Type::squoteClose: _content.append("’"); break;
-					case Punct::Type::hypen: _content.append("‐"); break;
-					case Punct::Type::enDash: _content.append("–"); break;
-					case Punct::Type::emDash: _content.append("—"); break;
+					case Punct::Type::quoteOpen: _sink->append("“"); break;
+					case Punct::Type::quoteClose: _sink->append("”"); break;
+					case Punct::Type::squoteOpen: _sink->append("‘"); break;
+					case Punct::Type::squoteClose: _sink->append("’"); break;
+					case Punct::Type::hypen: _sink->append("‐"); break;
+					case Punct::Type::enDash: _sink->append("–"); break;
+					case Punct::Type::emDash: _sink->append("—"); break;
 				}
 				break;
 			}
 			case NodeKind::quote: {
 				_indent += 1;
-				_content.append("\n");
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					_composeBlock(node->children[i]);
-				}
-				_indent -= 1;
+				_sink->append("\n");
+				_pushBlocks(node, 0, Close::indent);
 				break;
 			}
 			case NodeKind::accountTag: {
 				std::string_view res = static_cast<const AccountTag*>(node)->resource;
-				_content.append("@");
-				_content.append(res.data(), res.size());
+				_sink->append("@");
+				_sink->append(res.data(), res.size());
 				break;
 			}
 			case NodeKind::hashTag: {
 				std::string_view res = static_cast<const HashTag*>(node)->resource;
-				_content.append("#");
-				_content.append(res.data(), res.size());
+				_sink->append("#");
+				_sink->append(res.data(), res.size());
 				break;
 			}
 			case NodeKind::code: {
-				_content.append("`");
+				_sink->append("`");
 				std::string_view content = static_cast<const Code*>(node)->content;
-				_content.append(content.data(), content.size());
-				_content.append("`");
+				_sink->append(content.data(), content.size());
+				_sink->append("`");
 				break;
 			}
 			case NodeKind::link: {
 				const Link* link = static_cast<const Link*>(node);
-				_content.append("[");
+				_sink->append("[");
 				if (link->label.size() == 0) {
-					_content.append(link->resource.data(), link->resource.size());
+					_sink->append(link->resource.data(), link->resource.size());
 				} else {
-					_content.append(link->label.data(), link->label.size());
+					_sink->append(link->label.data(), link->label.size());
 				}
-				_content.append("](");
-				_content.append(link->resource.data(), link->resource.size());
-				_content.append(")");
+				_sink->append("](");
+				_sink->append(link->resource.data(), link->resource.size());
+				_sink->append(")");
 				break;
 			}
 			case NodeKind::view: {
 				const View* view = static_cast<const View*>(node);
-				_content.append("![");
+				_sink->append("![");
 				if (view->label.size() == 0) {
-					_content.append(view->resource.data(), view->resource.size());
+					_sink->append(view->resource.data(), view->resource.size());
 				} else {
-					_content.append(view->label.data(), view->label.size());
+					_sink->append(view->label.data(), view->label.size());
 				}
-				_content.append("](");
-				_content.append(view->resource.data(), view->resource.size());
-				_content.append(")");
+				_sink->append("](");
+				_sink->append(view->resource.data(), view->resource.size());
+				_sink->append(")");
 				break;
 			}
 			case NodeKind::emoji: {
 				const Emoji* emoji = static_cast<const Emoji*>(node);
 
-				_content.append(":");
+				_sink->append(":");
 				for (size_t i = 0; i < emoji->code.size(); i += 1) {
 					if (emoji->code[i] == '-') {
-						_content.append("_");
+						_sink->append("_");
 					} else {
-						_content.append(1, emoji->code[i]);
+						_sink->append(1, emoji->code[i]);
 					}
 				}
-				_content.append(":");
+				_sink->append(":");
 			}
 			case NodeKind::subtitle:
-				_content.append(": ");
-				for (size_t i = 0; i < node->children.size(); i += 1) {
-					_composeInline(node->children[i]);
-				}
+				_sink->append(": ");
+				_pushInlines(node, Close::none);
 				break;
 			default: 
 				break;
@@ -296,10 +414,13 @@ private:
 	}
 
 private:
-	std::string _content;
+	StringSink _content;
+	size_t _estimatedSize;
+	Sink* _sink;
 	bool _listItem;
 	size_t _listCount;
 	size_t _indent;
+	std::vector<Frame> _frames;
 };
 
 }
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Gularen/Frontend/Node.hpp"
+#include "Gularen/Frontend/NodeWalker.hpp"
+
+namespace Gularen {
+
+// Guesses the size of a composed output so that it can be reserved once.
+// Every composer weighs the parents, the leaves and the text of a size hint its own way,
+// a parent stands for the markup around its children and the text ends up escaped.
+class OutputEstimate {
+public:
+	static constexpr size_t base = 1024;
+
+	// The hint the parser tallied, a tree it did not build is counted in a pass over it instead.
+	// The pass counts the strings of the nodes as the text, a little less than the content they came from.
+	static SizeHint of(const Document* document) {
+		if (!document->sizeHint.empty()) {
+			return document->sizeHint;
+		}
+
+		SizeHint hint;
+		NodeWalker walker;
+
+		walker.walk(document, [&hint](const Node* node, size_t) {
+			hint.count(node->kind);
+			hint.textSize += _textSizeOf(node);
+			return true;
+		}, [](const Node*) {
+		});
+
+		return hint;
+	}
+
+	// perText is in sixteenths, the base keeps a short document whose markup outweighs its text from growing
+	static size_t size(const SizeHint& hint, size_t perParent, size_t perLeaf, size_t perText) {
+		return base + hint.parentCount * perParent + hint.leafCount * perLeaf + hint.textSize * perText / 16;
+	}
+
+private:
+	static size_t _textSizeOf(const Node* node) {
+		size_t size = 0;
+
+		for (size_t i = 0; i < node->annotations.size(); i += 1) {
+			size += node->annotations[i].key.size() + node->annotations[i].value.size();
+		}
+
+		switch (node->kind) {
+			case NodeKind::comment:
+				return size + static_cast<const Comment*>(node)->content.size();
+			case NodeKind::text:
+				return size + static_cast<const Text*>(node)->content.size();
+			case NodeKind::code:
+			case NodeKind::codeBlock: {
+				auto code = static_cast<const Code*>(node);
+				return size + code->label.size() + code->content.size();
+			}
+			case NodeKind::link: {
+				auto link = static_cast<const Link*>(node);
+				size += link->resource.size() + link->label.size();
+
+				for (size_t i = 0; i < link->headings.size(); i += 1) {
+					size += link->headings[i].size();
+				}
+
+				return size;
+			}
+			case NodeKind::view: {
+				auto view = static_cast<const View*>(node);
+				return size + view->resource.size() + view->label.size();
+			}
+			case NodeKind::footnote:
+				return size + static_cast<const Footnote*>(node)->desc.size();
+			case NodeKind::emoji:
+				return size + static_cast<const Emoji*>(node)->code.size();
+			case NodeKind::dateTime:
+				return size + static_cast<const DateTime*>(node)->content.size();
+			case NodeKind::admonition:
+				return size + static_cast<const Admonition*>(node)->label.size();
+			case NodeKind::accountTag:
+				return size + static_cast<const AccountTag*>(node)->resource.size();
+			case NodeKind::hashTag:
+				return size + static_cast<const HashTag*>(node)->resource.size();
+			case NodeKind::inText:
+				return size + static_cast<const InText*>(node)->id.size();
+			case NodeKind::reference:
+				return size + static_cast<const Reference*>(node)->id.size();
+			case NodeKind::referenceInfo:
+				return size + static_cast<const ReferenceInfo*>(node)->key.size();
+			default:
+				return size;
+		}
+	}
+};
+
+// How the estimate of an output held up once it was composed, growthCount is how often the
+// reserved buffer still had to grow.
+struct OutputStats {
+	size_t estimatedSize;
+	size_t size;
+	size_t growthCount;
+};
+
+}
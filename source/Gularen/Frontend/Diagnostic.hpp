@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Gularen/Frontend/Lexer.hpp"
+#include <string>
+
+namespace Gularen {
+
+// A problem the parser ran into. It keeps what the message is made of and puts
+// the message together only when asked, nobody pays for messages nobody reads.
+struct Diagnostic {
+	enum class Severity {
+		error,
+		warning,
+	};
+
+	enum class Code {
+		// detail is the whole message
+		message,
+
+		// expected is what the parser looked for
+		unexpectedEnd,
+		unexpectedToken,
+
+		// limit is the maximum depth
+		tooDeep,
+
+		// limit is the maximum content size in bytes
+		tooLarge,
+
+		// detail is the path of the included file
+		inclusionFolder,
+		inclusionMissing,
+		inclusionCycle,
+		inclusionTooDeep,
+	};
+
+	Severity severity;
+
+	Code code;
+
+	// the file the range is in, empty for content that is not from a file
+	std::string path;
+
+	Range range;
+
+	std::string_view expected;
+
+	TokenKind token;
+
+	size_t limit;
+
+	std::string detail;
+
+	Diagnostic(Code code, std::string_view path, Range range): code(code), path(path), range(range) {
+		severity = Severity::error;
+		token = TokenKind::end;
+		limit = 0;
+	}
+
+	std::string message() const {
+		switch (code) {
+			case Code::message:
+				return "[ParsingError] " + detail;
+			case Code::unexpectedEnd:
+				return "[ParsingError] unxpected end of file, expect " + std::string(expected);
+			case Code::unexpectedToken:
+				return "[ParsingError] unxpected token " + std::string(TokenKindHelper::toStringView(token)) + ", expect " + std::string(expected);
+			case Code::tooDeep:
+				return "[ParsingError] nesting is deeper than " + std::to_string(limit);
+			case Code::tooLarge:
+				return "[ParsingError] content is larger than " + std::to_string(limit) + " bytes";
+			case Code::inclusionFolder:
+				return "inclusion failed because \"" + detail + "\" is a folder";
+			case Code::inclusionMissing:
+				return "inclusion failed because file \"" + detail + "\" does not exists";
+			case Code::inclusionCycle:
+				return "inclusion failed because \"" + detail + "\" would include itself";
+			case Code::inclusionTooDeep:
+				return "inclusion failed because \"" + detail + "\" is nested deeper than " + std::to_string(limit);
+		}
+
+		return std::string();
+	}
+};
+
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "Gularen/Frontend/Node.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Gularen {
+
+// The AST as parallel arrays, one entry per node in document order.
+// A node is its index, the document itself is node 0. A pass over every node is
+// a walk along the arrays and a pass over one kind only touches the kinds.
+// What a node carries beyond its kind and range lives in the side tables:
+//   views: comment, text, emoji, footnote, inText, reference, referenceInfo and
+//          admonition hold their content; code and codeBlock the label and content;
+//          link the resource, the label and then the headings; view the resource
+//          and label; dateTime the date, time and content; the tags their resource
+//   values: emphasis, change, heading, row and punct hold their type; checkItem
+//           whether it is checked; table its alignments; document its index
+//           into paths and lineIndexes
+// An included document is a document node, its children are ranged in its own file.
+// The parser builds the node tree, assign takes a parsed tree apart for passes that read it whole.
+struct FlatDocument {
+	static constexpr uint32_t none = UINT32_MAX;
+
+	template <typename T>
+	struct Slice {
+		const T* items;
+		size_t count;
+
+		size_t size() const {
+			return count;
+		}
+
+		bool empty() const {
+			return count == 0;
+		}
+
+		const T& operator[](size_t index) const {
+			return items[index];
+		}
+
+		const T* begin() const {
+			return items;
+		}
+
+		const T* end() const {
+			return items + count;
+		}
+	};
+
+	std::vector<NodeKind> kinds;
+	std::vector<Range> ranges;
+	std::vector<uint32_t> parents;
+	std::vector<uint32_t> firstChildren;
+	std::vector<uint32_t> nextSiblings;
+
+	// where the entries of each node start in the side tables, they run until the next node's
+	std::vector<uint32_t> viewBegins;
+	std::vector<uint32_t> valueBegins;
+	std::vector<uint32_t> annotationBegins;
+
+	std::vector<std::string_view> views;
+	std::vector<uint32_t> values;
+	std::vector<Pair> annotations;
+
+	// one per document, the first one is the document itself
+	std::vector<std::string> paths;
+	std::vector<LineIndex> lineIndexes;
+
+	// the inputs the views point into
+	std::vector<FileBuffer> files;
+
+	// the cached parses of included files, the views of their nodes point into their inputs
+	std::vector<std::shared_ptr<const Document>> origins;
+
+	size_t size() const {
+		return kinds.size();
+	}
+
+	Slice<std::string_view> viewsOf(uint32_t node) const {
+		return _slice(views, viewBegins, node);
+	}
+
+	Slice<uint32_t> valuesOf(uint32_t node) const {
+		return _slice(values, valueBegins, node);
+	}
+
+	Slice<Pair> annotationsOf(uint32_t node) const {
+		return _slice(annotations, annotationBegins, node);
+	}
+
+	// Takes the tree apart, the files of the document and of its inclusions move over.
+	// A cached parse is shared with other trees, it is held on to and left as it is.
+	void assign(Document* document) {
+		_clear();
+
+		struct Frame {
+			const Node* node;
+			uint32_t index;
+			size_t next;
+			uint32_t previous;
+			bool shared;
+		};
+
+		std::vector<Frame> frames;
+		frames.push_back({ document, _append(document, none, false), 0, none, document->origin != nullptr });
+
+		while (!frames.empty()) {
+			Frame& frame = frames.back();
+
+			if (frame.next == frame.node->children.size()) {
+				frames.pop_back();
+				continue;
+			}
+
+			const Node* child = frame.node->children[frame.next];
+			uint32_t index = _append(child, frame.index, frame.shared);
+			bool shared = frame.shared || (child->kind == NodeKind::document && static_cast<const Document*>(child)->origin != nullptr);
+
+			if (frame.previous == none) {
+				firstChildren[frame.index] = index;
+			} else {
+				nextSiblings[frame.previous] = index;
+			}
+
+			frame.next += 1;
+			frame.previous = index;
+
+			// the frame reference is not used past this point, the push may move it
+			frames.push_back({ child, index, 0, none, shared });
+		}
+	}
+
+private:
+	template <typename T>
+	static Slice<T> _slice(const std::vector<T>& table, const std::vector<uint32_t>& begins, uint32_t node) {
+		size_t begin = begins[node];
+		size_t end = node + 1 < begins.size() ? begins[node + 1] : table.size();
+
+		return Slice<T> { table.data() + begin, end - begin };
+	}
+
+	void _clear() {
+		kinds.clear();
+		ranges.clear();
+		parents.clear();
+		firstChildren.clear();
+		nextSiblings.clear();
+		viewBegins.clear();
+		valueBegins.clear();
+		annotationBegins.clear();
+		views.clear();
+		values.clear();
+		annotations.clear();
+		paths.clear();
+		lineIndexes.clear();
+		files.clear();
+		origins.clear();
+	}
+
+	uint32_t _append(const Node* node, uint32_t parent, bool shared) {
+		uint32_t index = static_cast<uint32_t>(kinds.size());
+
+		kinds.push_back(node->kind);
+		ranges.push_back(node->range);
+		parents.push_back(parent);
+		firstChildren.push_back(none);
+		nextSiblings.push_back(none);
+		viewBegins.push_back(static_cast<uint32_t>(views.size()));
+		valueBegins.push_back(static_cast<uint32_t>(values.size()));
+		annotationBegins.push_back(static_cast<uint32_t>(annotations.size()));
+		annotations.insert(annotations.end(), node->annotations.begin(), node->annotations.end());
+
+		switch (node->kind) {
+			case NodeKind::document: {
+				auto document = static_cast<const Document*>(node);
+				values.push_back(static_cast<uint32_t>(paths.size()));
+				paths.push_back(document->path);
+
+				if (document->origin != nullptr) {
+					origins.push_back(document->origin);
+				}
+
+				if (shared) {
+					lineIndexes.push_back(document->lineIndex);
+					break;
+				}
+
+				// the tree is taken apart, so its own documents may give up their inputs
+				Document* owned = const_cast<Document*>(document);
+				lineIndexes.push_back(std::move(owned->lineIndex));
+				files.push_back(std::move(owned->file));
+				break;
+			}
+			case NodeKind::comment:
+				views.push_back(static_cast<const Comment*>(node)->content);
+				break;
+			case NodeKind::text:
+				views.push_back(static_cast<const Text*>(node)->content);
+				break;
+			case NodeKind::emphasis:
+				values.push_back(static_cast<uint32_t>(static_cast<const Emphasis*>(node)->type));
+				break;
+			case NodeKind::change:
+				values.push_back(static_cast<uint32_t>(static_cast<const Change*>(node)->type));
+				break;
+			case NodeKind::heading:
+				values.push_back(static_cast<uint32_t>(static_cast<const Heading*>(node)->type));
+				break;
+			case NodeKind::checkItem:
+				values.push_back(static_cast<const CheckItem*>(node)->checked);
+				break;
+			case NodeKind::table:
+				for (Table::Alignment alignment : static_cast<const Table*>(node)->alignments) {
+					values.push_back(static_cast<uint32_t>(alignment));
+				}
+				break;
+			case NodeKind::row:
+				values.push_back(static_cast<uint32_t>(static_cast<const Row*>(node)->type));
+				break;
+			case NodeKind::code:
+			case NodeKind::codeBlock: {
+				auto code = static_cast<const Code*>(node);
+				views.push_back(code->label);
+				views.push_back(code->content);
+				break;
+			}
+			case NodeKind::link: {
+				auto link = static_cast<const Link*>(node);
+				views.push_back(link->resource);
+				views.push_back(link->label);
+				views.insert(views.end(), link->headings.begin(), link->headings.end());
+				break;
+			}
+			case NodeKind::view: {
+				auto view = static_cast<const View*>(node);
+				views.push_back(view->resource);
+				views.push_back(view->label);
+				break;
+			}
+			case NodeKind::footnote:
+				views.push_back(static_cast<const Footnote*>(node)->desc);
+				break;
+			case NodeKind::inText:
+				views.push_back(static_cast<const InText*>(node)->id);
+				break;
+			case NodeKind::referenceInfo:
+				views.push_back(static_cast<const ReferenceInfo*>(node)->key);
+				break;
+			case NodeKind::reference:
+				views.push_back(static_cast<const Reference*>(node)->id);
+				break;
+			case NodeKind::emoji:
+				views.push_back(static_cast<const Emoji*>(node)->code);
+				break;
+			case NodeKind::dateTime: {
+				auto dateTime = static_cast<const DateTime*>(node);
+				views.push_back(dateTime->date);
+				views.push_back(dateTime->time);
+				views.push_back(dateTime->content);
+				break;
+			}
+			case NodeKind::punct:
+				values.push_back(static_cast<uint32_t>(static_cast<const Punct*>(node)->type));
+				break;
+			case NodeKind::admonition:
+				views.push_back(static_cast<const Admonition*>(node)->label);
+				break;
+			case NodeKind::accountTag:
+				views.push_back(static_cast<const AccountTag*>(node)->resource);
+				break;
+			case NodeKind::hashTag:
+				views.push_back(static_cast<const HashTag*>(node)->resource);
+				break;
+			default:
+				break;
+		}
+
+		return index;
+	}
+};
+
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "Gularen/Frontend/Node.hpp"
+#include "Gularen/Frontend/NodeWalker.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Gularen {
+
+// Included files that were parsed already, shared by every parser it is given to.
+// A file is known by its canonical path and the maximum depth it was parsed with, and stays
+// valid while its size and modification time stay the same, and those of every file it
+// includes at any level. The documents are never changed
+// again, an inclusion of one takes its children over by pointer and holds on to the document.
+// Safe to use from several threads.
+class IncludeCache {
+public:
+	struct Key {
+		std::string path;
+		uintmax_t size;
+		std::filesystem::file_time_type time;
+		size_t maximumDepth;
+	};
+
+	IncludeCache() {
+		_hits = 0;
+		_misses = 0;
+	}
+
+	// Returns an empty path when the file cannot be looked at.
+	static std::string canonicalOf(std::string_view path) {
+		std::error_code error;
+		std::filesystem::path canonical = std::filesystem::canonical(path, error);
+
+		return error ? std::string() : canonical.string();
+	}
+
+	// Returns false when the file cannot be looked at, it is not cached then.
+	// The path is canonical, from canonicalOf(), maximumDepth is the one of the parser.
+	static bool keyOf(const std::string& canonicalPath, size_t maximumDepth, Key& key) {
+		if (canonicalPath.empty()) {
+			return false;
+		}
+
+		std::error_code error;
+		key.size = std::filesystem::file_size(canonicalPath, error);
+
+		if (error) {
+			return false;
+		}
+
+		key.time = std::filesystem::last_write_time(canonicalPath, error);
+
+		if (error) {
+			return false;
+		}
+
+		key.path = canonicalPath;
+		key.maximumDepth = maximumDepth;
+
+		return true;
+	}
+
+	// Returns null when the file is not cached, it or a file it includes has changed since, or it
+	// cannot be included where it is: a file of the chain that includes it is one it includes
+	// itself, or its inclusions go inclusionRoom levels deep or more. It is parsed in turn then,
+	// which reports why.
+	std::shared_ptr<const Document> find(const Key& key, const std::vector<std::string>& chain, size_t inclusionRoom) {
+		std::shared_ptr<const Document> document;
+		std::vector<Key> inclusions;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto entry = _entries.find(key.path);
+
+			if (entry != _entries.end() && _matches(entry->second, key) && entry->second.height < inclusionRoom) {
+				document = entry->second.document;
+				inclusions = entry->second.inclusions;
+			}
+		}
+
+		for (const Key& inclusion : inclusions) {
+			if (std::find(chain.begin(), chain.end(), inclusion.path) != chain.end()) {
+				document = nullptr;
+				break;
+			}
+		}
+
+		// the included files are looked at outside the lock
+		if (document != nullptr && !_unchanged(inclusions)) {
+			document = nullptr;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (document != nullptr) {
+			_hits += 1;
+		} else {
+			_misses += 1;
+		}
+
+		return document;
+	}
+
+	// Whether find() would return the file for a chain it is not part of, without counting it as a hit or a miss.
+	bool contains(const Key& key) const {
+		std::vector<Key> inclusions;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto entry = _entries.find(key.path);
+
+			if (entry == _entries.end() || !_matches(entry->second, key)) {
+				return false;
+			}
+
+			inclusions = entry->second.inclusions;
+		}
+
+		return _unchanged(inclusions);
+	}
+
+	// A document that includes a file that cannot be looked at is not kept, it could not be told apart when it changes.
+	void insert(const Key& key, std::shared_ptr<const Document> document) {
+		Entry entry { key.size, key.time, key.maximumDepth, 0, {}, std::move(document) };
+
+		if (!_collectGraph(entry)) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_entries[key.path] = std::move(entry);
+	}
+
+	// The documents stay alive in the trees that include them.
+	void clear() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_entries.clear();
+		_hits = 0;
+		_misses = 0;
+	}
+
+	size_t hits() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _hits;
+	}
+
+	size_t misses() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _misses;
+	}
+
+private:
+	struct Entry {
+		uintmax_t size;
+		std::filesystem::file_time_type time;
+		size_t maximumDepth;
+
+		// how many levels of inclusion the document has below it
+		size_t height;
+
+		// the files it includes at every level, as they were when it was inserted
+		std::vector<Key> inclusions;
+
+		std::shared_ptr<const Document> document;
+	};
+
+	static bool _matches(const Entry& entry, const Key& key) {
+		return entry.size == key.size && entry.time == key.time && entry.maximumDepth == key.maximumDepth;
+	}
+
+	static bool _unchanged(const std::vector<Key>& inclusions) {
+		for (const Key& inclusion : inclusions) {
+			Key current;
+
+			if (!keyOf(inclusion.path, inclusion.maximumDepth, current) || current.size != inclusion.size || current.time != inclusion.time) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// The inclusion graph is looked at once here rather than on every hit, returns false when
+	// an included file cannot be looked at.
+	static bool _collectGraph(Entry& entry) {
+		const Document* root = entry.document.get();
+		size_t level = 0;
+		bool known = true;
+		NodeWalker walker;
+
+		walker.walk(root, [&](const Node* node, size_t) {
+			if (node->kind == NodeKind::document && node != root) {
+				auto document = static_cast<const Document*>(node);
+				Key key;
+				level += 1;
+				entry.height = std::max(entry.height, level);
+
+				if (keyOf(canonicalOf(document->path), entry.maximumDepth, key)) {
+					entry.inclusions.push_back(std::move(key));
+				} else {
+					known = false;
+				}
+			}
+
+			return true;
+		}, [&](const Node* node) {
+			if (node->kind == NodeKind::document && node != root) {
+				level -= 1;
+			}
+		});
+
+		return known;
+	}
+
+	mutable std::mutex _mutex;
+
+	std::unordered_map<std::string, Entry> _entries;
+
+	size_t _hits;
+
+	size_t _misses;
+};
+
+}
@@ -1,11 +1,20 @@
 #pragma once
 
-#include <vector>
+#include "Gularen/Library/CharClass.hpp"
+#include "Gularen/Library/RingBuffer.hpp"
+#include "Gularen/Library/Scanner.hpp"
+#include "Gularen/Library/Tasks.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace Gularen {
 
-enum class TokenKind {
+enum class TokenKind : uint16_t {
 	comment,
 	annotationKey,
 	annotationValue,
@@ -93,6 +102,9 @@ enum class TokenKind {
 
 	accountTag,
 	hashTag,
+
+	// past the last token, never produced by the lexer
+	end,
 };
 
 struct TokenKindHelper {
@@ -184,45 +196,572 @@ struct TokenKindHelper {
 			case TokenKind::accountTag: return "accountTag";
 			case TokenKind::hashTag: return "hashTag";
 
+			case TokenKind::end: return "end";
+
 			default: return "";
 		}
 	}
 };
 
+// Byte offsets into the content, end is inclusive.
+// Use the LineIndex of the document to turn them into line and column.
 struct Range {
-	size_t startLine;
-	size_t startColumn;
-	size_t endLine;
-	size_t endColumn;
+	size_t begin;
+	size_t end;
 };
 
+// Positions are byte offsets into the lexed content, so documents are limited to 4 GiB.
 struct Token {
-	Range range;
+	// content is [offset, offset + size)
+	uint32_t offset;
+	uint32_t size;
+
+	// range is [offset - lead, end], inclusive like Range
+	uint32_t end;
 	TokenKind kind;
-	std::string_view content;
+	uint16_t lead;
 };
 
+static_assert(sizeof(Token) == 16, "tokens are kept compact, the lexer produces millions of them");
+// Lexes the whole content at once with parse(), or on demand in pull mode.
+// Pull mode starts with stream(), fetch() lexes a block at a time until the
+// requested token is there and discard() lets go of the tokens behind the reader,
+// so only a small window of tokens is alive at any time.
+// Token indexes are absolute in both modes.
+//
+// Pull mode also takes the content in chunks from a reader. A step that runs into
+// the end of the buffered input is rolled back and run again once more input is
+// buffered, so the tokens are the same as for the whole content. Token offsets are
+// then positions in the whole input, modulo 2^32, and the window must stay below 4 GiB.
 class Lexer {
 public:
+	// Fills the buffer with up to size bytes and returns the count, zero at the end of the input.
+	using Reader = std::function<size_t(char* buffer, size_t size)>;
+
+	static constexpr size_t chunkSize = 64 * 1024;
+
+	// the most content parse() takes, the token offsets are 32-bit; streamed input wraps around instead
+	static constexpr size_t maximumContentSize = UINT32_MAX;
+
+	// the density of prose with light markup, the specification has about one token for every six bytes
+	static constexpr double defaultTokensPerByte = 1.0 / 6;
+
+	// removedSize bytes at offset were replaced by insertedSize bytes
+	struct Edit {
+		size_t offset;
+		size_t removedSize;
+		size_t insertedSize;
+	};
+
+	Lexer() {
+		_tokensPerByte = defaultTokensPerByte;
+	}
+
 	void parse(std::string_view content) {
+		stream(content);
+		_tokens.reserve(_estimateTokenCount(content.size()));
+
+		while (!_finished) {
+			_step();
+		}
+
+		_learnTokenDensity(content.size());
+	}
+
+	// Lexes chunks of the content on threadCount threads, the tokens are the same as from parse().
+	// The chunks start after blank lines at indent level zero. A chunk is lexed as if the lexer
+	// had just read the blank line, which is true unless the blank line is part of a raw span or
+	// a code block. The chunks are checked in order, a chunk whose start the lexer before it does
+	// not stop at is dropped, and that lexer goes on in its place.
+	void parse(std::string_view content, size_t threadCount) {
+		std::vector<size_t> starts = _splitPoints(content, threadCount);
+
+		if (starts.size() <= 1) {
+			parse(content);
+			return;
+		}
+
+		std::vector<Lexer> chunks(starts.size());
+
+		Tasks::run(chunks.size(), threadCount, [&](size_t index) {
+			size_t limit = index + 1 < starts.size() ? starts[index + 1] : content.size();
+			chunks[index]._tokensPerByte = _tokensPerByte;
+			chunks[index]._lexFrom(content, starts[index], limit);
+		});
+
+		// the lexers whose tokens are known to be right, the last one is never behind the next chunk start
+		std::vector<Lexer*> lexers { &chunks[0] };
+
+		for (size_t i = 1; i < chunks.size(); i += 1) {
+			Lexer* lexer = lexers.back();
+
+			if (!lexer->_finished && lexer->_contentIndex < starts[i]) {
+				lexer->_lexUntil(starts[i]);
+			}
+
+			if (!lexer->_finished && lexer->_contentIndex == starts[i] && lexer->_isRestart(starts[i])) {
+				lexers.push_back(&chunks[i]);
+			}
+		}
+
+		while (!lexers.back()->_finished) {
+			lexers.back()->_step();
+		}
+
+		std::vector<size_t> firstTokens;
+		size_t tokenCount = 0;
+
+		for (const Lexer* lexer : lexers) {
+			firstTokens.push_back(tokenCount);
+			tokenCount += lexer->_tokens.size();
+		}
+
+		stream(content);
+		_tokens.resize(tokenCount);
+
+		Tasks::run(lexers.size(), threadCount, [&](size_t index) {
+			const RingBuffer<Token>& tokens = lexers[index]->_tokens;
+
+			for (size_t i = 0; i < tokens.size(); i += 1) {
+				_tokens[firstTokens[index] + i] = tokens[i];
+			}
+		});
+
+		_lastKind = lexers.back()->_lastKind;
+		_contentIndex = lexers.back()->_contentIndex;
+		_finished = true;
+
+		_learnTokenDensity(content.size());
+	}
+
+	void stream(std::string_view content) {
+		_reset();
+		_content = content;
+		_endOfInput = true;
+	}
+
+	void stream(Reader reader) {
+		_reset();
+		_reader = std::move(reader);
+		_endOfInput = false;
+	}
+
+	// Returns false when the content has no token at index.
+	bool fetch(size_t index) {
+		// one token of lookahead, the last token may still change when the content ends
+		while (!_finished && size() <= index + 1) {
+			_step();
+		}
+
+		return index < size();
+	}
+
+	// Returns the token at index, or an end token past the last one.
+	Token get(size_t index) {
+		if (!fetch(index)) {
+			uint32_t size = static_cast<uint32_t>(_base + _content.size());
+			return Token { size, 0, size, TokenKind::end, 0 };
+		}
+
+		return _tokens[index - _discarded];
+	}
+
+	// Tokens before index are no longer accessible.
+	// With a reader, neither is the input before them, nothing may point into it anymore.
+	void discard(size_t index) {
+		if (index > _discarded) {
+			size_t count = std::min(index - _discarded, _tokens.size());
+			_tokens.popFront(count);
+			_discarded += count;
+		}
+
+		if (_reader) {
+			// _consumeQuote looks one byte back
+			_keep = std::min(_rangeBegin, _contentIndex == 0 ? 0 : _contentIndex - 1);
+
+			if (!_tokens.empty()) {
+				_keep = std::min(_keep, _index(_tokens[0].offset - _tokens[0].lead));
+			}
+
+			_recycleRetired();
+		}
+	}
+
+	const Token& operator[](size_t index) const {
+		return _tokens[index - _discarded];
+	}
+
+	// the number of tokens lexed so far, all of them after parse()
+	inline size_t size() const {
+		return _discarded + _tokens.size();
+	}
+
+	std::string_view content(const Token& token) const {
+		return _content.substr(_index(token.offset), token.size);
+	}
+
+	Range range(const Token& token) const {
+		return Range { _base + _index(token.offset - token.lead), _base + _index(token.end) };
+	}
+
+	// Lexes the content again after an edit and returns the number of bytes lexed again.
+	// The content is the whole content after the edit and the tokens must come from parse() of the content before it.
+	// Lexing restarts at the last line start before the edit that follows a newline token at indent level zero,
+	// no raw span or code block crosses one, and stops at the first such line start after the edit that the old
+	// tokens had too. The old tokens from there on are shifted and kept.
+	size_t edit(std::string_view content, const Edit& edit) {
+		size_t restartIndex = _restartIndex(content, edit.offset);
+		size_t restart = restartIndex == 0 ? 0 : _begin(_tokens[restartIndex]);
+
+		// the new tokens are lexed into an empty buffer that starts at the restart token
+		RingBuffer<Token> oldTokens;
+		std::swap(oldTokens, _tokens);
+
 		_content = content;
+		_contentIndex = restart;
+		_rangeBegin = restart;
+		_indentLevel = 0;
+		_discarded = restartIndex;
+		_lastKind = restartIndex == 0 ? TokenKind::end : oldTokens[restartIndex - 1].kind;
+		_started = restartIndex != 0;
+		_finished = false;
+		_endOfInput = true;
+
+		// offsets behind the edit move by the size difference, modulo 2^32 like the offsets
+		uint32_t shift = static_cast<uint32_t>(edit.insertedSize - edit.removedSize);
+		size_t editEnd = edit.offset + edit.insertedSize;
+		size_t oldIndex = restartIndex;
+		bool synchronized = false;
+
+		while (!_finished) {
+			_step();
+
+			if (_finished || _contentIndex <= editEnd || !_isRestart(_contentIndex)) {
+				continue;
+			}
+
+			// the old tokens at the same line start, they were lexed from the same state
+			uint32_t oldBegin = static_cast<uint32_t>(_contentIndex) - shift;
+
+			while (oldIndex < oldTokens.size() && _begin(oldTokens[oldIndex]) < oldBegin) {
+				oldIndex += 1;
+			}
+
+			while (oldIndex < oldTokens.size() && _begin(oldTokens[oldIndex]) == oldBegin && oldTokens[oldIndex].kind == TokenKind::indentClose) {
+				oldIndex += 1;
+			}
+
+			if (oldIndex == 0 || oldIndex == oldTokens.size() || _begin(oldTokens[oldIndex]) != oldBegin || !_isRestartKind(oldTokens[oldIndex - 1].kind)) {
+				continue;
+			}
+
+			synchronized = true;
+			break;
+		}
+
+		size_t lexedSize = (synchronized ? _contentIndex : _content.size()) - restart;
+
+		if (!synchronized) {
+			oldIndex = oldTokens.size();
+
+			// the end of the content may have turned the newline before the restart into newline+
+			if (_tokens.empty() && restartIndex != 0) {
+				oldTokens[restartIndex - 1].kind = _lastKind;
+			}
+		}
+
+		oldTokens.splice(restartIndex, oldIndex - restartIndex, _tokens);
+
+		for (size_t i = restartIndex + _tokens.size(); i < oldTokens.size(); i += 1) {
+			oldTokens[i].offset += shift;
+			oldTokens[i].end += shift;
+		}
+
+		std::swap(oldTokens, _tokens);
+		_discarded = 0;
+		_lastKind = _tokens.empty() ? TokenKind::end : _tokens.back().kind;
+		_finished = true;
+
+		return lexedSize;
+	}
+
+	// the buffered input, it starts at base() and baseLine() of the whole input
+	std::string_view window() const {
+		return _content;
+	}
+
+	size_t base() const {
+		return _base;
+	}
+
+	size_t baseLine() const {
+		return _baseLine;
+	}
+
+private:
+	struct Checkpoint {
+		size_t contentIndex;
+		size_t rangeBegin;
+		size_t indentLevel;
+		size_t tokenCount;
+		TokenKind lastKind;
+	};
+
+	// an eighth more than the density predicts, a slightly denser document should not double the buffer
+	size_t _estimateTokenCount(size_t size) const {
+		return static_cast<size_t>(size * _tokensPerByte * 1.125);
+	}
+
+	// documents in a batch tend to look alike, the next one is expected to be like the last ones
+	void _learnTokenDensity(size_t size) {
+		if (size != 0) {
+			_tokensPerByte = (_tokensPerByte + static_cast<double>(_tokens.size()) / size) / 2;
+		}
+	}
+
+	// start of the token range
+	static uint32_t _begin(const Token& token) {
+		return token.offset - token.lead;
+	}
+
+	static bool _isRestartKind(TokenKind kind) {
+		return kind == TokenKind::newline || kind == TokenKind::newlinePlus || kind == TokenKind::indentClose;
+	}
+
+	// between steps, right after a newline token on a line without indentation
+	bool _isRestart(size_t index) const {
+		return _indentLevel == 0 && index > 0 && _content[index - 1] == '\n' && _isRestartKind(_lastKind);
+	}
+
+	// index of the last restart token that starts before offset, zero when there is none
+	size_t _restartIndex(std::string_view content, size_t offset) const {
+		// the tokens are ordered by their range start
+		size_t low = 0;
+		size_t high = _tokens.size();
+
+		while (low < high) {
+			size_t middle = low + (high - low) / 2;
+
+			if (_begin(_tokens[middle]) < offset) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+
+		// the step before a restart looked one byte past it for indentation, so the restart must be before the edit
+		for (size_t i = std::min(low, _tokens.size() - 1); i > 0; i -= 1) {
+			const Token& token = _tokens[i];
+			size_t begin = _begin(token);
+
+			if (begin < offset && begin > 0 && content[begin - 1] == '\n' && token.kind != TokenKind::indentOpen && token.kind != TokenKind::indentClose && _isRestartKind(_tokens[i - 1].kind)) {
+				return i;
+			}
+		}
+
+		return 0;
+	}
+
+	// line starts after a blank line at indent level zero, one chunk for each start
+	static std::vector<size_t> _splitPoints(std::string_view content, size_t threadCount) {
+		// a few chunks for each thread evens out the load, a chunk must be worth a task
+		constexpr size_t minimumChunkSize = 256 * 1024;
+		size_t chunkCount = std::min(threadCount * 4, content.size() / minimumChunkSize);
+
+		std::vector<size_t> starts { 0 };
+
+		if (threadCount <= 1) {
+			return starts;
+		}
+
+		const char* data = content.data();
+
+		for (size_t i = 1; i < chunkCount; i += 1) {
+			size_t index = std::max(content.size() / chunkCount * i, starts.back() + 1);
+
+			while (index < content.size()) {
+				const char* newline = static_cast<const char*>(std::memchr(data + index, '\n', content.size() - index));
+
+				if (newline == nullptr) {
+					return starts;
+				}
+
+				index = newline - data + 1;
+
+				if (index >= content.size() || data[index] != '\n') {
+					continue;
+				}
+
+				while (index < content.size() && data[index] == '\n') {
+					index += 1;
+				}
+
+				if (index < content.size() && data[index] != '\t') {
+					starts.push_back(index);
+					break;
+				}
+			}
+		}
+
+		return starts;
+	}
+
+	// a chunk starts as if the lexer had just read the blank line in front of it
+	void _lexFrom(std::string_view content, size_t index, size_t limit) {
+		stream(content);
+		_tokens.reserve(_estimateTokenCount(limit - index));
+
+		if (index != 0) {
+			_contentIndex = index;
+			_rangeBegin = index;
+			_lastKind = TokenKind::newlinePlus;
+			_started = true;
+		}
+
+		_lexUntil(limit);
+	}
+
+	// lexes until a step ends at or past limit, or the content ends
+	void _lexUntil(size_t limit) {
+		do {
+			_step();
+		} while (!_finished && _contentIndex < limit);
+	}
+
+	void _reset() {
+		_content = std::string_view();
 		_contentIndex = 0;
+		_rangeBegin = 0;
 		_indentLevel = 0;
 
-		_line = 0;
-		_column = 0;
+		_tokens.clear();
+		_discarded = 0;
+		_lastKind = TokenKind::end;
+		_started = false;
+		_finished = false;
 
-		_saveRangeStart();
+		_reader = nullptr;
+		// the buffers stay for the next input, the views into them are dead by now
+		_recycleRetired();
+
+		if (_buffer.size() > _spare.size()) {
+			_spare.swap(_buffer);
+		}
+
+		_buffer.clear();
+		_base = 0;
+		_baseLine = 0;
+		_keep = 0;
+		_starved = false;
+	}
+
+	// buffer index of a token offset, see the class comment about wrapping
+	size_t _index(uint32_t offset) const {
+		return static_cast<uint32_t>(offset - static_cast<uint32_t>(_base));
+	}
+
+	void _step() {
+		Checkpoint checkpoint { _contentIndex, _rangeBegin, _indentLevel, _tokens.size(), _lastKind };
+		_starved = false;
+
+		if (!_started) {
+			_saveRangeStart();
+			_consumeIndent();
+		} else if (_isBound(0)) {
+			_parseBlock();
+		}
 
-		_consumeIndent();
-		_parseBlock();
+		if (_starved) {
+			_contentIndex = checkpoint.contentIndex;
+			_rangeBegin = checkpoint.rangeBegin;
+			_indentLevel = checkpoint.indentLevel;
+			_tokens.popBack(_tokens.size() - checkpoint.tokenCount);
+			_lastKind = checkpoint.lastKind;
+			_refill();
+			return;
+		}
+
+		_started = true;
+
+		if (!_isBound(0)) {
+			if (_endOfInput) {
+				_finish();
+				return;
+			}
+
+			_refill();
+		}
+	}
+
+	void _refill() {
+		// the window starts on a line start, so a column is the same in the window and in the input
+		while (_keep > 0 && _content[_keep - 1] != '\n') {
+			_keep -= 1;
+		}
 
-		if (_tokens.size() != 0) {
-			switch (_tokens[_tokens.size() - 1].kind) {
+		size_t live = _content.size() - _keep;
+
+		// grows with the window, a step longer than a chunk is not lexed over and over
+		size_t want = std::max(chunkSize, live);
+
+		if (_content.size() + want > _buffer.size()) {
+			// the bytes are never moved in place, the block being parsed still points into them
+			std::string buffer;
+			size_t size = std::max(_buffer.size(), live * 2 + want);
+
+			if (_spare.size() >= size) {
+				buffer.swap(_spare);
+			} else {
+				buffer.assign(size, '\0');
+			}
+			if (live != 0) {
+				std::memcpy(buffer.data(), _content.data() + _keep, live);
+			}
+
+			_baseLine += std::count(_content.data(), _content.data() + _keep, '\n');
+			_base += _keep;
+			_contentIndex -= _keep;
+			_rangeBegin -= _keep;
+			_keep = 0;
+
+			_retired.push_back(std::move(_buffer));
+			_buffer = std::move(buffer);
+			_content = std::string_view(_buffer.data(), live);
+		}
+
+		size_t count = _reader(_buffer.data() + _content.size(), want);
+
+		if (count == 0) {
+			_endOfInput = true;
+		}
+
+		_content = std::string_view(_buffer.data(), _content.size() + count);
+	}
+
+	// keeps the largest outgrown buffer, so a steady stream swaps between two buffers
+	void _recycleRetired() {
+		for (std::string& buffer : _retired) {
+			if (buffer.size() > _spare.size()) {
+				_spare.swap(buffer);
+			}
+		}
+
+		_retired.clear();
+	}
+
+	void _finish() {
+		_finished = true;
+
+		if (size() != 0) {
+			switch (_lastKind) {
 				case TokenKind::newlinePlus: 
 					break;
 				case TokenKind::newline: 
-					_tokens[_tokens.size() - 1].kind = TokenKind::newlinePlus;
+					_lastKind = TokenKind::newlinePlus;
+
+					if (!_tokens.empty()) {
+						_tokens.back().kind = TokenKind::newlinePlus;
+					}
 					break;
 				default: 
 					_append(TokenKind::newlinePlus);
@@ -232,159 +771,146 @@ public:
 		}
 	}
 
-	const Token& operator[](size_t index) const {
-		return _tokens[index];
-	}
-
-	inline size_t size() const {
-		return _tokens.size();
-	}
-
-private:
+	// one block construct, or one line of inline content
 	void _parseBlock() {
-		while (_isBound(0)) {
-			_saveRangeStart();
+		_saveRangeStart();
 
-			switch (_get(0)) {
-				case '>': 
-					if (_isBound(1) && _get(1) == '>') {
-						if (_isBound(2) && _get(2) == '>') {
-							if (_isBound(3) && _get(3) == ' ') {
-								_append(TokenKind::head3, _contentIndex, 3);
-								_advance(4);
-								break;
-							}
-						}
+		if (!CharClass::is(_get(0), CharClass::blockStart)) {
+			_parseInline();
+			return;
+		}
 
-						if (_isBound(2) && _get(2) == ' ') {
-							_append(TokenKind::head2, _contentIndex, 2);
-							_advance(3);
+		switch (_get(0)) {
+			case '>': 
+				if (_isBound(1) && _get(1) == '>') {
+					if (_isBound(2) && _get(2) == '>') {
+						if (_isBound(3) && _get(3) == ' ') {
+							_append(TokenKind::head3, _contentIndex, 3);
+							_advance(4);
 							break;
 						}
 					}
 
-					if (_isBound(1) && _get(1) == ' ') {
-						_append(TokenKind::head1, _contentIndex, 1);
-						_advance(2);
+					if (_isBound(2) && _get(2) == ' ') {
+						_append(TokenKind::head2, _contentIndex, 2);
+						_advance(3);
 						break;
 					}
+				}
 
-					_consumeText();
+				if (_isBound(1) && _get(1) == ' ') {
+					_append(TokenKind::head1, _contentIndex, 1);
+					_advance(2);
 					break;
+				}
 
-				case '/':
-					if (_isBound(1) && _get(1) == '/') {
-						_advance(1);
+				_consumeText();
+				break;
 
-						size_t oldContentIndex = _contentIndex;
+			case '/':
+				if (_isBound(1) && _get(1) == '/') {
+					_advance(1);
 
-						while (_isBound(0)) {
-							if (_get(0) == '/' && _isBound(1) && _get(1) == '/') {
-								break;
-							}
+					size_t oldContentIndex = _contentIndex;
 
-							_advance(1);
+					while (_isBound(0)) {
+						if (_get(0) == '/' && _isBound(1) && _get(1) == '/') {
+							break;
 						}
 
-						_contentIndex = oldContentIndex;
+						_advance(1);
 					}
 
-					_parseInline();
-					break;
-
-				case '-':
-					if (_isBound(1) && _get(1) == ' ') {
-						_append(TokenKind::bullet, _contentIndex, 1);
-						_advance(2);
-						break;
-					}
+					_contentIndex = oldContentIndex;
+				}
 
-					if (_isBound(2) && _get(1) == '-' && _get(2) == '-') {
-						_consumeCodeBlock();
-						break;
-					}
+				_parseInline();
+				break;
 
-					_parseInline();
+			case '-':
+				if (_isBound(1) && _get(1) == ' ') {
+					_append(TokenKind::bullet, _contentIndex, 1);
+					_advance(2);
 					break;
+				}
 
-				case '(':
-					if (_isBound(3) && _get(3) == ' ' && _get(2) == ')') {
-						if (_get(1) == '!') {
-							_append(TokenKind::admonition, _contentIndex, 3);
-							_advance(4);
+				if (_isBound(2) && _get(1) == '-' && _get(2) == '-') {
+					_consumeCodeBlock();
+					break;
+				}
 
-							size_t startIndex = _contentIndex;
-							_saveRangeStart();
+				_parseInline();
+				break;
 
-							while (_isBound(0)) {
-								if (_get(0) == ':') {
-									_append(TokenKind::admonitionLabel, startIndex, _contentIndex - startIndex);
-									_advance(1);
-									break;
-								}
+			case '(':
+				if (_isBound(3) && _get(3) == ' ' && _get(2) == ')') {
+					if (_get(1) == '!') {
+						_append(TokenKind::admonition, _contentIndex, 3);
+						_advance(4);
 
-								if (_get(0) == '\n') {
-									_append(TokenKind::admonitionLabel, startIndex, _contentIndex - startIndex);
-									break;
-								}
+						size_t startIndex = _contentIndex;
+						_saveRangeStart();
 
+						while (_isBound(0)) {
+							if (_get(0) == ':') {
+								_append(TokenKind::admonitionLabel, startIndex, _contentIndex - startIndex, _contentIndex - 1);
 								_advance(1);
+								break;
 							}
-							break;
-						}
 
-						if (_get(1) == '&') {
-							_append(TokenKind::reference, _contentIndex, 3);
-							_advance(4);
+							if (_get(0) == '\n') {
+								_append(TokenKind::admonitionLabel, startIndex, _contentIndex - startIndex, _contentIndex - 1);
+								break;
+							}
+
+							_advance(1);
+						}
+						break;
+					}
 
-							size_t startIndex = _contentIndex;
-							_saveRangeStart();
+					if (_get(1) == '&') {
+						_append(TokenKind::reference, _contentIndex, 3);
+						_advance(4);
 
-							while (_isBound(0)) {
-								if (_get(0) == '\n') {
-									_append(TokenKind::referenceID, startIndex, _contentIndex - startIndex);
-									break;
-								}
+						size_t startIndex = _contentIndex;
+						_saveRangeStart();
 
-								_advance(1);
+						while (_isBound(0)) {
+							if (_get(0) == '\n') {
+								_append(TokenKind::referenceID, startIndex, _contentIndex - startIndex, _contentIndex - 1);
+								break;
 							}
+
+							_advance(1);
 						}
 					}
+				}
 
-					_parseInline();
-					break;
+				_parseInline();
+				break;
 
-				case '0':
-				case '1':
-				case '2':
-				case '3':
-				case '4':
-				case '5':
-				case '6':
-				case '7':
-				case '8':
-				case '9':
-					_consumeIndex();
+			case '?':
+				if (_isBound(1) && _get(1) == '[') {
+					_append(TokenKind::question, _contentIndex, 1);
+					_advance(1);
 					break;
+				}
 
-				case '?':
-					if (_isBound(1) && _get(1) == '[') {
-						_append(TokenKind::question, _contentIndex, 1);
-						_advance(1);
-						break;
-					}
+				_consumeText();
+				break;
 
-					_consumeText();
-					break;
+			case '|':
+				_consumePipe();
+				break;
 
-				case '|':
-					_consumePipe();
+			default: 
+				if (CharClass::isDigit(_get(0))) {
+					_consumeIndex();
 					break;
+				}
 
-				default: 
-					_parseInline(); 
-					break;
-			}
+				_parseInline(); 
+				break;
 		}
 	}
 
@@ -392,6 +918,11 @@ private:
 		while (_isBound(0)) {
 			_saveRangeStart();
 
+			if (!CharClass::is(_get(0), CharClass::inlineDelimiter)) {
+				_consumeText();
+				continue;
+			}
+
 			switch (_get(0)) {
 				case '~':
 					_consumeComment();
@@ -424,15 +955,7 @@ private:
 
 				case '=': 
 					if (_get(1) == '=') {
-						_saveRangeStart();
-						Token token;
-						token.range.startLine = _oldLine;
-						token.range.startColumn = _oldColumn;
-						token.range.endLine = _oldLine;
-						token.range.endColumn = _oldLine + 2;
-						token.kind = TokenKind::text;
-						token.content = _content.substr(_contentIndex, 2);
-						_tokens.push_back(static_cast<Token&&>(token));
+						_append(TokenKind::text, _contentIndex, 2);
 						_advance(2);
 						break;
 					}
@@ -472,24 +995,24 @@ private:
 						break;
 					}
 
-					if (_get(1) >= '0' && _get(1) <= '9') {
+					if (CharClass::isDigit(_get(1))) {
 						_advance(1);
 						size_t oldContentIndex = _contentIndex;
 
 						// check for date or time
-						while (_isBound(0) && ((_get(0) >= '0' && _get(0) <= '9') || _get(0) == '-' || _get(0) == ':')) {
+						while (_isBound(0) && (CharClass::isDigit(_get(0)) || _get(0) == '-' || _get(0) == ':')) {
 							_advance(1);
 						}
 
-						if (_isBound(1) && _get(0) == ' ' && (_get(1) >= '0' && _get(1) <= '9')) {
+						if (_isBound(1) && _get(0) == ' ' && CharClass::isDigit(_get(1))) {
 							_advance(1);
 							// check for time
-							while (_isBound(0) && ((_get(0) >= '0' && _get(0) <= '9') || _get(0) == ':')) {
+							while (_isBound(0) && (CharClass::isDigit(_get(0)) || _get(0) == ':')) {
 								_advance(1);
 							}
 						}
 
-						_append(TokenKind::dateTime, oldContentIndex, _contentIndex - oldContentIndex, Range { _oldLine, _oldColumn, _line, _column - 1 });
+						_append(TokenKind::dateTime, oldContentIndex, _contentIndex - oldContentIndex, _contentIndex - 1);
 						break;
 					}
 
@@ -596,29 +1119,25 @@ private:
 					}
 					
 					size_t openingContextIndex = _contentIndex;
-					if (_isBound(1) && ((_get(1) >= 'a' && _get(1) <= 'z') || _get(1) == '-')) {
+					if (_isBound(1) && CharClass::is(_get(1), CharClass::emojiChar)) {
 						_advance(1);
-						while (_isBound(0) && ((_get(0) >= 'a' && _get(0) <= 'z') || _get(0) == '-')) {
+						while (_isBound(0) && CharClass::is(_get(0), CharClass::emojiChar)) {
 							_advance(1);
 						}
 						if (_isBound(0) && _get(0) == ':') {
-							_append(TokenKind::emoji, openingContextIndex + 1, _contentIndex - openingContextIndex - 1, Range {
-								_oldLine, _oldColumn, _line, _column
-							});
+							_append(TokenKind::emoji, openingContextIndex + 1, _contentIndex - openingContextIndex - 1, _contentIndex);
 							_advance(1);
 							break;
 						}
 					}
 					_advance(1);
-					_append(TokenKind::text, openingContextIndex, _contentIndex - openingContextIndex, Range {
-						_oldLine, _oldColumn, _line, _column - 1
-					});
+					_append(TokenKind::text, openingContextIndex, _contentIndex - openingContextIndex, _contentIndex - 1);
 					break;
 				}
 
 				case '"':
 					_consumeQuote(
-						(_tokens.size() != 0 && _tokens.back().kind == TokenKind::squoteOpen), // ‘“ case
+						(size() != 0 && _lastKind == TokenKind::squoteOpen), // ‘“ case
 						TokenKind::quoteOpen, 
 						TokenKind::quoteClose
 					);
@@ -627,7 +1146,7 @@ private:
 
 				case '\'':
 					_consumeQuote(
-						(_tokens.size() != 0 && _tokens.back().kind == TokenKind::quoteOpen), // “‘ case
+						(size() != 0 && _lastKind == TokenKind::quoteOpen), // “‘ case
 						TokenKind::squoteOpen, 
 						TokenKind::squoteClose
 					);
@@ -649,25 +1168,16 @@ private:
 					while (_isBound(0) && _get(0) == '\n') {
 						count += 1;
 						_advance(1);
-						_advanceLine(1);
 					}
 
-					Token token;
-					token.range.startLine = _oldLine;
-					token.range.startColumn = _oldColumn;
-					token.range.endLine = _oldLine;
-					token.range.endColumn = _oldColumn;
-
 					if (count == 1) {
-						token.kind = TokenKind::newline;
-						_tokens.push_back(static_cast<Token&&>(token));
+						_push(TokenKind::newline, _rangeBegin, _rangeBegin);
 						_saveRangeStart();
 						_consumeIndent();
 						return;
 					}
 
-					token.kind = TokenKind::newlinePlus;
-					_tokens.push_back(static_cast<Token&&>(token));
+					_push(TokenKind::newlinePlus, _rangeBegin, _rangeBegin);
 					_saveRangeStart();
 					_consumeIndent();
 					return;
@@ -677,16 +1187,11 @@ private:
 					_advance(1);
 					size_t oldContentIndex = _contentIndex;
 
-					while (_isBound(0) && (
-						(_get(0) >= 'a' && _get(0) <= 'z') ||
-						(_get(0) >= 'A' && _get(0) <= 'Z') ||
-						(_get(0) >= '0' && _get(0) <= '9') ||
-						(_get(0) == '_')
-					)) {
+					while (_isBound(0) && CharClass::is(_get(0), CharClass::tagChar)) {
 						_advance(1);
 					}
 
-					_append(TokenKind::accountTag, oldContentIndex, _contentIndex - oldContentIndex, Range { _oldLine, _oldColumn, _line, _column - 1 });
+					_append(TokenKind::accountTag, oldContentIndex, _contentIndex - oldContentIndex, _contentIndex - 1);
 					break;
 				}
 
@@ -694,16 +1199,11 @@ private:
 					_advance(1);
 					size_t oldContentIndex = _contentIndex;
 
-					while (_isBound(0) && (
-						(_get(0) >= 'a' && _get(0) <= 'z') ||
-						(_get(0) >= 'A' && _get(0) <= 'Z') ||
-						(_get(0) >= '0' && _get(0) <= '9') ||
-						(_get(0) == '_')
-					)) {
+					while (_isBound(0) && CharClass::is(_get(0), CharClass::tagChar)) {
 						_advance(1);
 					}
 
-					_append(TokenKind::hashTag, oldContentIndex, _contentIndex - oldContentIndex, Range { _oldLine, _oldColumn, _line, _column - 1 });
+					_append(TokenKind::hashTag, oldContentIndex, _contentIndex - oldContentIndex, _contentIndex - 1);
 					break;
 				}
 
@@ -715,46 +1215,65 @@ private:
 	}
 
 private:
-	bool _isBound(size_t offset) const {
-		return _contentIndex + offset < _content.size();
+	bool _isBound(size_t offset) {
+		if (_contentIndex + offset < _content.size()) {
+			return true;
+		}
+
+		if (!_endOfInput) {
+			_starved = true;
+		}
+
+		return false;
 	}
 
 	void _advance(size_t offset) {
 		_contentIndex += offset;
-		_column += offset;
-	}
-
-	void _advanceLine(size_t offset) {
-		_line += offset;
-		_column = 0;
 	}
 
 	void _saveRangeStart() {
-		_oldLine = _line;
-		_oldColumn = _column;
+		_rangeBegin = _contentIndex;
 	}
 
-	char _get(size_t offset) const {
+
+	// Past the content this is '\0', a mapped file has no terminator after its last byte.
+	char _get(size_t offset) {
+		// some lookaheads are not bound checked, they must not decide on bytes that are not read yet
+		if (_contentIndex + offset >= _content.size()) {
+			if (!_endOfInput) {
+				_starved = true;
+			}
+
+			return '\0';
+		}
+
 		return _content[_contentIndex + offset];
 	}
 
+	// the token starts at the current index
 	void _append(TokenKind kind, size_t index = 0, size_t size = 0) {
-		Token token;
-		token.range.startLine = _oldLine;
-		token.range.startColumn = _oldColumn;
-		token.range.endLine = _line;
-		token.range.endColumn = _column + (size == 0 ? 0 : size - 1);
-		token.kind = kind;
-		token.content = _content.substr(index, size);
-		_tokens.push_back(static_cast<Token&&>(token));
+		_push(kind, _rangeBegin, _contentIndex + (size == 0 ? 0 : size - 1), index, size);
+	}
+
+	void _append(TokenKind kind, size_t index, size_t size, size_t end) {
+		_push(kind, _rangeBegin, end, index, size);
 	}
 
-	void _append(TokenKind kind, size_t index, size_t size, Range range) {
+	void _push(TokenKind kind, size_t begin, size_t end, size_t index = 0, size_t size = 0) {
+		// empty content sits at the range start, which keeps the lead small
+		if (size == 0) {
+			index = begin;
+		}
+
 		Token token;
-		token.range = range;
+		token.offset = static_cast<uint32_t>(_base + index);
+		token.size = static_cast<uint32_t>(size);
+		token.end = static_cast<uint32_t>(_base + end);
 		token.kind = kind;
-		token.content = _content.substr(index, size);
-		_tokens.push_back(static_cast<Token&&>(token));
+		// a range that starts further out is cut to start where the lead still reaches
+		token.lead = static_cast<uint16_t>(std::min<size_t>(index - begin, UINT16_MAX));
+		_tokens.pushBack(token);
+		_lastKind = kind;
 	}
 
 	void _consumeIndent() {
@@ -767,13 +1286,7 @@ private:
 
 		if (_indentLevel < indentLevel) {
 			while (_indentLevel < indentLevel) {
-				Token token;
-				token.range.startLine = _oldLine;
-				token.range.startColumn = _oldColumn;
-				token.range.endLine = _oldLine;
-				token.range.endColumn = _oldColumn;
-				token.kind = TokenKind::indentOpen;
-				_tokens.push_back(static_cast<Token&&>(token));
+				_push(TokenKind::indentOpen, _rangeBegin, _rangeBegin);
 				_indentLevel += 1;
 			}
 		}
@@ -787,11 +1300,7 @@ private:
 	}
 
 	void _consumeQuote(bool condition, TokenKind left, TokenKind right) {
-		if (_contentIndex == 0 || 
-			_content[_contentIndex - 1] == ' ' || 
-            _content[_contentIndex - 1] == '\t' || 
-            _content[_contentIndex - 1] == '\n' || 
-            condition) {
+		if (_contentIndex == 0 || CharClass::is(_content[_contentIndex - 1], CharClass::whitespace) || condition) {
 			_append(left, _contentIndex, 1);
 			_advance(1);
             return;
@@ -809,12 +1318,7 @@ private:
 			_advance(3);
 			size_t keyIndex = _contentIndex;
 
-			while (_isBound(0) && (
-				(_get(0) >= 'a' && _get(0) <= 'z') ||
-				(_get(0) >= 'A' && _get(0) <= 'Z') ||
-				(_get(0) >= '0' && _get(0) <= '9') ||
-				(_get(0) == '-')
-			)) {
+			while (_isBound(0) && CharClass::is(_get(0), CharClass::keyChar)) {
 				_advance(1);
 			}
 			
@@ -825,7 +1329,7 @@ private:
 			}
 
 			if (_isBound(0) && _get(0) == '=') {
-				_append(TokenKind::annotationKey, keyIndex, keyEndIndex - keyIndex);
+				_append(TokenKind::annotationKey, keyIndex, keyEndIndex - keyIndex, keyEndIndex - 1);
 				_advance(1);
 
 				while (_isBound(0) && _get(0) == ' ') {
@@ -837,10 +1341,10 @@ private:
 					_advance(1);
 				}
 
-				_append(TokenKind::annotationValue, valueIndex, _contentIndex - valueIndex);
+				// the value range starts at the value, a long key would not fit the token lead
+				_push(TokenKind::annotationValue, valueIndex, _contentIndex - 1, valueIndex, _contentIndex - valueIndex);
 
 				if (_isBound(0) && _get(0) == '\n') {
-					_advanceLine(1);
 					_advance(1);
 				}
 				return;
@@ -851,18 +1355,10 @@ private:
 			_advance(1);
 		}
 
-		Token token;
-		token.range.startLine = _oldLine;
-		token.range.startColumn = _oldColumn;
-		token.range.endLine = _line;
-		token.range.endColumn = _column - 1;
-		token.kind = TokenKind::comment;
-		token.content = _content.substr(beginIndex, _contentIndex - beginIndex);
-		_tokens.push_back(static_cast<Token&&>(token));
+		_append(TokenKind::comment, beginIndex, _contentIndex - beginIndex, _contentIndex - 1);
 
 		if (_isBound(0) && _get(0) == '\n') {
 			_advance(1);
-			_advanceLine(1);
 		}
 	}
 
@@ -871,31 +1367,19 @@ private:
 		size_t beginIndex = _contentIndex;
 
 		while (_isBound(0)) {
-			switch (_get(0)) {
-				// fast early lookup
-				case ' ':
-				case ',':
-				case '.':
-					previousAlphanumeric = false;
-					_advance(1);
-					break;
+			// fast early lookup, only delimiters can end a run
+			size_t plainIndex = Scanner::skipPlain(_content, _contentIndex);
 
-				case '0': case '1': case '2': case '3': case '4':
-				case '5': case '6': case '7': case '8': case '9':
+			if (plainIndex != _contentIndex) {
+				previousAlphanumeric = CharClass::isAlphanumeric(_content[plainIndex - 1]);
+				_advance(plainIndex - _contentIndex);
 
-				case 'A': case 'B': case 'C': case 'D': case 'E': case 'F': case 'G':
-				case 'H': case 'I': case 'J': case 'K': case 'L': case 'M':
-				case 'N': case 'O': case 'P': case 'Q': case 'R': case 'S': case 'T': 
-				case 'U': case 'V': case 'W': case 'X': case 'Y': case 'Z':
-
-				case 'a': case 'b': case 'c': case 'd': case 'e': case 'f': case 'g':
-				case 'h': case 'i': case 'j': case 'k': case 'l': case 'm':
-				case 'n': case 'o': case 'p': case 'q': case 'r': case 's': case 't': 
-				case 'u': case 'v': case 'w': case 'x': case 'y': case 'z':
-					previousAlphanumeric = true;
-					_advance(1);
+				if (!_isBound(0)) {
 					break;
+				}
+			}
 
+			switch (_get(0)) {
 				case '*':
 				case '/':
 				case '_':
@@ -935,7 +1419,7 @@ private:
 
 				case '+':
 					previousAlphanumeric = false;
-					if (_isBound(1) && ((_get(1) >= '0' && _get(1) <= '9') || _get(1) == ')')) {
+					if (_isBound(1) && (CharClass::isDigit(_get(1)) || _get(1) == ')')) {
 						goto end;
 					}
 
@@ -961,14 +1445,7 @@ private:
 
 		end:
 
-		Token token;
-		token.range.startLine = _oldLine;
-		token.range.startColumn = _oldColumn;
-		token.range.endLine = _line;
-		token.range.endColumn = _column - 1;
-		token.kind = TokenKind::text;
-		token.content = _content.substr(beginIndex, _contentIndex - beginIndex);
-		_tokens.push_back(static_cast<Token&&>(token));
+		_append(TokenKind::text, beginIndex, _contentIndex - beginIndex, _contentIndex - 1);
 
 		return;
 	}
@@ -976,7 +1453,7 @@ private:
 	void _consumeIndex() {
 		size_t beginIndex = _contentIndex;
 
-		while (_isBound(0) && _get(0) >= '0' && _get(0) <= '9') {
+		while (_isBound(0) && CharClass::isDigit(_get(0))) {
 			_advance(1);
 		}
 
@@ -1058,9 +1535,7 @@ private:
 			_advance(1);
 		}
 
-		_append(TokenKind::raw, oldContextIndex, _contentIndex - oldContextIndex, Range{
-			_oldLine, _oldColumn, _line, _column - 1
-		});
+		_append(TokenKind::raw, oldContextIndex, _contentIndex - oldContextIndex, _contentIndex - 1);
 		_saveRangeStart();
 
 		if (_isBound(0) && _get(0) == ')') {
@@ -1080,9 +1555,7 @@ private:
 			_advance(1);
 		}
 
-		_append(TokenKind::raw, oldContextIndex, _contentIndex - oldContextIndex, Range{
-			_oldLine, _oldColumn, _line, _column - 1
-		});
+		_append(TokenKind::raw, oldContextIndex, _contentIndex - oldContextIndex, _contentIndex - 1);
 		_saveRangeStart();
 
 		if (_isBound(0) && _get(0) == ']') {
@@ -1113,15 +1586,7 @@ private:
 			_advance(1);
 		}
 
-		Token token;
-		token.range.startLine = _oldLine;
-		token.range.startColumn = _oldColumn;
-		token.range.endLine = _line;
-		token.range.endColumn = _column - 1;
-		token.kind = TokenKind::raw;
-		token.content = _content.substr(oldContextIndex, _contentIndex - oldContextIndex);
-		_tokens.push_back(static_cast<Token&&>(token));
-
+		_append(TokenKind::raw, oldContextIndex, _contentIndex - oldContextIndex, _contentIndex - 1);
 		_saveRangeStart();
 
 		if (_isBound(0) && _get(0) == '`') {
@@ -1136,9 +1601,8 @@ private:
 
 		while (_isBound(0)) {
 			if (_isBound(0) && _get(0) == '\n') {
-				size_t oldColumn = _column;
+				size_t newlineIndex = _contentIndex;
 				_advance(1);
-				_advanceLine(1);
 				size_t indentLevel = 0;
 				while (_isBound(0) && _get(0) == '\t') {
 					_advance(1);
@@ -1158,14 +1622,7 @@ private:
 							}
 						}
 
-						Token token;
-						token.range.startLine = _oldLine;
-						token.range.startColumn = _oldColumn;
-						token.range.endLine = _line - 1;
-						token.range.endColumn = oldColumn;
-						token.kind = TokenKind::raw;
-						token.content = _content.substr(oldContextIndex + 1, size);
-						_tokens.push_back(static_cast<Token&&>(token));
+						_append(TokenKind::raw, oldContextIndex + 1, size, newlineIndex);
 						_saveRangeStart();
 
 						_append(TokenKind::fenceClose, _contentIndex, dashCount);
@@ -1179,7 +1636,7 @@ private:
 			_advance(1);
 		}
 
-		_append(TokenKind::raw, oldContextIndex + 1, _contentIndex - oldContextIndex - 1);
+		_append(TokenKind::raw, oldContextIndex + 1, _contentIndex - oldContextIndex - 1, _contentIndex - 1);
 	}
 
 	void _consumeCodeBlock() {
@@ -1192,14 +1649,7 @@ private:
 		size_t dashCount = _contentIndex - oldContentIndex;
 
 		if (_isBound(0) && _get(0) == '\n') {
-			Token token;
-			token.range.startLine = _oldLine;
-			token.range.startColumn = _oldColumn;
-			token.range.endLine = _line;
-			token.range.endColumn = _column - 1;
-			token.kind = TokenKind::fenceOpen;
-			token.content = _content.substr(oldContentIndex, _contentIndex - oldContentIndex);
-			_tokens.push_back(static_cast<Token&&>(token));
+			_append(TokenKind::fenceOpen, oldContentIndex, _contentIndex - oldContentIndex, _contentIndex - 1);
 			_saveRangeStart();
 
 			return _consumeCodeBlockContent(dashCount);
@@ -1207,7 +1657,6 @@ private:
 
 		// capture label
 		if (_isBound(1) && _get(0) == ' ' && _get(1) != '\n') {
-			size_t oldColumn = _column;
 			size_t youngContextIndex = _contentIndex;
 			_advance(1);
 			size_t middleAgedContentIndex = _contentIndex;
@@ -1217,24 +1666,10 @@ private:
 			}
 
 			if (_isBound(0) && _get(0) == '\n') {
-				Token token;
-				token.range.startLine = _oldLine;
-				token.range.startColumn = _oldColumn;
-				token.range.endLine = _line;
-				token.range.endColumn = oldColumn - 1;
-				token.kind = TokenKind::fenceOpen;
-				token.content = _content.substr(oldContentIndex, youngContextIndex - oldContentIndex);
-				_tokens.push_back(static_cast<Token&&>(token));
+				_append(TokenKind::fenceOpen, oldContentIndex, youngContextIndex - oldContentIndex, youngContextIndex - 1);
 				_saveRangeStart();
 
-				Token token2;
-				token2.range.startLine = _oldLine;
-				token2.range.startColumn = oldColumn + 1;
-				token2.range.endLine = _line;
-				token2.range.endColumn = _column - 1;
-				token2.kind = TokenKind::text;
-				token2.content = _content.substr(middleAgedContentIndex, _contentIndex - middleAgedContentIndex);
-				_tokens.push_back(static_cast<Token&&>(token2));
+				_push(TokenKind::text, middleAgedContentIndex, _contentIndex - 1, middleAgedContentIndex, _contentIndex - middleAgedContentIndex);
 				_saveRangeStart();
 
 				return _consumeCodeBlockContent(dashCount);
@@ -1250,17 +1685,47 @@ private:
 
 	size_t _contentIndex;
 
-	size_t _line;
+	size_t _rangeBegin;
+
+	RingBuffer<Token> _tokens;
 
-	size_t _column;
+	// absolute index of the first token in _tokens
+	size_t _discarded;
 
-	size_t _oldLine;
+	// the window may have let go of the last token already
+	TokenKind _lastKind;
 
-	size_t _oldColumn;
+	bool _started;
 
-	std::vector<Token> _tokens;
+	bool _finished;
+
+	Reader _reader;
+
+	std::string _buffer;
+
+	// buffers that were outgrown while a block still pointed into them
+	std::vector<std::string> _retired;
+
+	// an outgrown buffer that nothing points into anymore, the next one to grow into
+	std::string _spare;
+
+	// position of _content in the whole input
+	size_t _base;
+
+	size_t _baseLine;
+
+	// the input before this index is no longer needed
+	size_t _keep;
+
+	bool _endOfInput;
+
+	// the current step looked past the buffered input
+	bool _starved;
 
 	size_t _indentLevel;
+
+	// learned from the documents lexed so far, sizes the token buffer up front
+	double _tokensPerByte;
 };
 
 }
@@ -2,6 +2,11 @@
 
 #include "Gularen/Frontend/Helper.hpp"
 #include "Gularen/Frontend/Lexer.hpp"
+#include "Gularen/Library/Arena.hpp"
+#include "Gularen/Library/ArenaVector.hpp"
+#include "Gularen/Library/FileBuffer.hpp"
+#include "Gularen/Library/LineIndex.hpp"
+#include <memory>
 #include <string>
 
 namespace Gularen {
@@ -65,37 +70,116 @@ enum class NodeKind {
 	hashTag,
 };
 
+// Tallied as the nodes of a document are created, the composers guess the size of their output by it.
+// A parent is a node of a kind that wraps what is in it in markup, the text is the content parsed.
+struct SizeHint {
+	size_t parentCount;
+
+	size_t leafCount;
+
+	size_t textSize;
+
+	SizeHint() {
+		parentCount = 0;
+		leafCount = 0;
+		textSize = 0;
+	}
+
+	bool empty() const {
+		return parentCount == 0 && leafCount == 0;
+	}
+
+	void count(NodeKind kind) {
+		switch (kind) {
+			case NodeKind::comment:
+			case NodeKind::text:
+			case NodeKind::space:
+			case NodeKind::lineBreak:
+			case NodeKind::pageBreak:
+			case NodeKind::dinkus:
+			case NodeKind::code:
+			case NodeKind::codeBlock:
+			case NodeKind::view:
+			case NodeKind::footnote:
+			case NodeKind::inText:
+			case NodeKind::referenceInfo:
+			case NodeKind::punct:
+			case NodeKind::emoji:
+			case NodeKind::dateTime:
+			case NodeKind::accountTag:
+			case NodeKind::hashTag:
+				leafCount += 1;
+				return;
+			default:
+				parentCount += 1;
+				return;
+		}
+	}
+
+	void add(const SizeHint& other) {
+		parentCount += other.parentCount;
+		leafCount += other.leafCount;
+		textSize += other.textSize;
+	}
+};
+
 struct Pair {
 	std::string_view key;
 	std::string_view value;
 };
 
+// The nodes and their lists live in the arena of the document and are never destroyed one by one,
+// a node has to stay trivially destructible so that releasing the arena does not visit it.
 struct Node {
 	Range range;
 	NodeKind kind;
-	std::vector<Node*> children;
-	std::vector<Pair> annotations;
+	ArenaVector<Node*> children;
+	ArenaVector<Pair> annotations;
 
 	Node(Range range, NodeKind kind): range(range), kind(kind)  {
 	}
-
-	virtual ~Node() {
-		for (size_t i = 0; i < children.size(); i += 1) {
-			delete children[i];
-			children[i] = nullptr;
-		}
-	}
 };
 
 struct Document : Node {
 	std::string path;
+
+	// the annotations of a streamed document, the window they came from is gone
 	std::string content;
 
+	// the input of a parsed file, the children point into it
+	FileBuffer file;
+
+	// every node below the document, included documents too
+	Arena arena;
+
+	// resolves the ranges of the children, the range of the document itself belongs to the including document
+	LineIndex lineIndex;
+
+	// the cached parse of an included file whose children this document shares, it keeps them alive
+	std::shared_ptr<const Document> origin;
+
+	// what the parser saw of the nodes below, empty for a tree it did not build
+	SizeHint sizeHint;
+
 	Document(): Node({}, NodeKind::document) {
 	}
 
 	Document(Range range, std::string_view path): Node(range, NodeKind::document), path(path) {
 	}
+
+	// Empties the document for another parse, the arena and the buffers keep their memory.
+	void clear() {
+		range = Range();
+		children = ArenaVector<Node*>();
+		annotations = ArenaVector<Pair>();
+		path.clear();
+		content.clear();
+		file.close();
+		arena.clear();
+		lineIndex.assign(std::string_view());
+		origin.reset();
+		sizeHint = SizeHint();
+	}
 };
 
 
@@ -240,7 +324,7 @@ struct Table : Node {
 		right,
 	};
 
-	std::vector<Alignment> alignments;
+	ArenaVector<Alignment> alignments;
 
 	Table(Range range): Node(range, NodeKind::table) {
 	}
@@ -280,13 +364,13 @@ struct CodeBlock : Code {
 
 struct Link : Node {
 	std::string_view resource;
-	std::vector<std::string_view> headings;
+	ArenaVector<std::string_view> headings;
 	std::string_view label;
 
 	Link(Range range): Node(range, NodeKind::link) {
 	}
 
-	void setResource(std::string_view resource) {
+	void setResource(std::string_view resource, Arena& arena) {
 		bool found = false;
 		size_t startIndex = 0;
 
@@ -305,14 +389,14 @@ struct Link : Node {
 			while (index < resource.size()) {
 				if (resource[index] == '>') {
 					std::string_view division = resource.substr(startIndex + 1, index - startIndex - 1);
-					headings.push_back(division);
+					headings.push_back(division, arena);
 					startIndex = index;
 				}
 				index += 1;
 			}
 
 			std::string_view division = resource.substr(startIndex + 1, index - startIndex - 1);
-			headings.push_back(division);
+			headings.push_back(division, arena);
 		}
 	}
 };
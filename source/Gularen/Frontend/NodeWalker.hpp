@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Gularen/Frontend/Node.hpp"
+#include <vector>
+
+namespace Gularen {
+
+// Walks a tree in document order on an explicit stack, a deep tree does not reach the call stack.
+// enter(node, index) runs before the children, index is the position of the node among its
+// siblings, and returns whether to go into the children. leave(node) runs after them, only for
+// the nodes that were gone into. The callbacks may walk again with the same walker.
+class NodeWalker {
+public:
+	template <typename Enter, typename Leave>
+	void walk(const Node* root, Enter&& enter, Leave&& leave) {
+		if (!enter(root, 0)) {
+			return;
+		}
+
+		size_t base = _frames.size();
+		_frames.push_back({ root, 0 });
+
+		while (_frames.size() > base) {
+			Frame& frame = _frames.back();
+
+			if (frame.next == frame.node->children.size()) {
+				const Node* node = frame.node;
+				_frames.pop_back();
+				leave(node);
+				continue;
+			}
+
+			size_t index = frame.next;
+			const Node* child = frame.node->children[index];
+			frame.next += 1;
+
+			// the frame is not touched past this point, a nested walk may move it
+			if (enter(child, index)) {
+				_frames.push_back({ child, 0 });
+			}
+		}
+	}
+
+private:
+	struct Frame {
+		const Node* node;
+		size_t next;
+	};
+
+	std::vector<Frame> _frames;
+};
+
+}
@@ -1,20 +1,47 @@
 #pragma once
 
+#include "Gularen/Frontend/Diagnostic.hpp"
+#include "Gularen/Frontend/IncludeCache.hpp"
 #include "Gularen/Frontend/Lexer.hpp"
 #include "Gularen/Frontend/Node.hpp"
+#include "Gularen/Frontend/NodeWalker.hpp"
+#include "Gularen/Library/Tasks.hpp"
 #include <filesystem>
 #include <fstream>
-#include <iostream>
+#include <functional>
+#include <istream>
+#include <memory>
 
 namespace Gularen {
 
 class Parser {
 public:
+	static constexpr size_t defaultMaximumDepth = 1024;
+
+	// every included file in the chain is a parser on the stack
+	static constexpr size_t defaultMaximumInclusionDepth = 32;
+
+	// One edge of the inclusion graph, the file at path includes the file at includedPath at range.
+	struct Inclusion {
+		std::string path;
+		std::string includedPath;
+		Range range;
+	};
+
 	Parser() {
 		_document = nullptr;
+		_includeCache = nullptr;
+		_prefetched = false;
+		_workspaceFolderDeduced = false;
 		_fileInclusion = true;
 		_error = false;
 		_stopped = false;
+		_maximumDepth = defaultMaximumDepth;
+		_maximumInclusionDepth = defaultMaximumInclusionDepth;
+		_inclusionDepth = 0;
+		_lexingThreadCount = 0;
+		_inclusionThreadCount = 1;
+		_depth = 0;
 	}
 
 	~Parser() {
@@ -22,65 +49,351 @@ public:
 		_document = nullptr;
 	}
 
+	// The parser owns the returned document until the next parse or reset(), release() takes it over.
 	Document* parseFile(std::string_view path) {
-		_document = new Document();
+		_prepare();
 		_document->path = path;
+		_deduceWorkspaceFolder(path);
 
-		if (_workspaceFolder.empty()) {
-			for (size_t i = path.size(); i > 0; i -= 1) {
-				if (path[i - 1] == '/') {
-					_workspaceFolder = std::string(path.data(), i - 1);
-					break;
-				}
-			}
-
-			if (_workspaceFolder.size() == 0) {
-				_workspaceFolder = ".";
-			}
+		if (!_document->file.open(path)) {
+			return nullptr;
 		}
 
+		return _parse(_document->file.view());
+	}
+
+	// Content of 4 GiB or more is not parsed, the document stays empty with a tooLarge diagnostic.
+	Document* parse(std::string_view content) {
+		_prepare();
+
+		return _parse(content);
+	}
+
+	// Receives each top-level block of a streamed document as soon as it closes.
+	// The block and the input it points into are released when the handler returns.
+	using BlockHandler = std::function<void(const Document& document, Node* block)>;
+
+	// Parses input that arrives in chunks, memory is bounded by the largest block instead of the input.
+	// The returned document has the annotations and the range but no children,
+	// its line index covers the buffered input while a handler runs.
+	Document* parseStream(Lexer::Reader reader, BlockHandler handler) {
+		_prepare();
+
+		return _parseStream(std::move(reader), handler);
+	}
+
+	Document* parseStream(std::istream& stream, BlockHandler handler) {
+		_prepare();
+
+		return _parseStream(_readerOf(stream), handler);
+	}
+
+	Document* parseFileStream(std::string_view path, BlockHandler handler) {
 		std::ifstream file;
 		file.open(std::string(path));
 
 		if (!file.is_open()) {
-			delete _document;
-			_document = nullptr;
 			return nullptr;
 		}
 
-		_document->content.assign(std::filesystem::file_size(path), '\0');
-		file.read(_document->content.data(), _document->content.size());
+		_prepare();
+		_document->path = path;
+		_deduceWorkspaceFolder(path);
 
-		return _parse(std::string_view(_document->content.data(), _document->content.size()));
+		return _parseStream(_readerOf(file), handler);
 	}
 
-	Document* parse(std::string_view content) {
-		_document = new Document();
+	// Empties the parser for the next document, every parse starts with it. The document is
+	// cleared but keeps its memory, and so do the flat document, the lexer and the parser itself,
+	// so a parser that is reused stops asking the system for memory once it has seen its largest input.
+	// Whatever a parse returned before is gone, release() the document to keep it.
+	void reset() {
+		if (_document != nullptr) {
+			_document->clear();
+		}
 
-		return _parse(content);
+		if (_workspaceFolderDeduced) {
+			_workspaceFolder.clear();
+			_workspaceFolderDeduced = false;
+		}
+
+		if (_prefetched) {
+			_prefetchCache.clear();
+			_prefetched = false;
+		}
+
+		_annotations.clear();
+		_styles.clear();
+		_quotes.clear();
+		_diagnostics.clear();
+		_error = false;
+		_stopped = false;
+	}
+
+	// Hands the last parsed document over, the next parse starts a new one.
+	std::unique_ptr<Document> release() {
+		std::unique_ptr<Document> document(_document);
+		_document = nullptr;
+
+		return document;
+	}
+
+	using DiagnosticHandler = std::function<void(const Diagnostic& diagnostic)>;
+
+	// Receives each diagnostic as it is reported, those of an included file once the file is parsed.
+	// Nothing is printed by the parser, a handler or diagnostics() is the only way to them.
+	void setDiagnosticHandler(DiagnosticHandler handler) {
+		_diagnosticHandler = std::move(handler);
+	}
+
+	// The diagnostics of the last parse and of the files it included, in the order they were reported.
+	const std::vector<Diagnostic>& diagnostics() const {
+		return _diagnostics;
 	}
 
 	void setWorkspaceFolder(std::string_view path) {
 		_workspaceFolder = path;
+		_workspaceFolderDeduced = false;
 	}
 
 	void setFileInclusion(bool state) {
 		_fileInclusion = state;
 	}
 
+	// Included files are looked up in the cache before they are parsed and kept in it after,
+	// the cache is not owned and may be shared with other parsers. Null parses every inclusion.
+	void setIncludeCache(IncludeCache* cache) {
+		_includeCache = cache;
+	}
+
+	// How deep included files may include further files, the inclusion fails past it.
+	// A file that includes itself, directly or through others, fails at once.
+	void setMaximumInclusionDepth(size_t depth) {
+		_maximumInclusionDepth = depth;
+	}
+
+	// The inclusion graph of the last parse, in document order with the inclusions of an
+	// included file right after it. The paths are canonical where the files can be found.
+	std::vector<Inclusion> inclusions() const {
+		std::vector<Inclusion> inclusions;
+
+		if (_document == nullptr) {
+			return inclusions;
+		}
+
+		std::vector<std::string> paths { _canonicalOrSame(_document->path) };
+		NodeWalker walker;
+
+		walker.walk(_document, [&](const Node* node, size_t) {
+			if (node->kind == NodeKind::document && node != _document) {
+				auto document = static_cast<const Document*>(node);
+				paths.push_back(_canonicalOrSame(document->path));
+				inclusions.push_back({ paths[paths.size() - 2], paths.back(), document->range });
+			}
+
+			return true;
+		}, [&](const Node* node) {
+			if (node->kind == NodeKind::document && node != _document) {
+				paths.pop_back();
+			}
+		});
+
+		return inclusions;
+	}
+
+	// Parses the files a document includes on up to count threads before the document itself.
+	// The tree and the diagnostics are the same as when the files are parsed in turn.
+	void setInclusionThreadCount(size_t count) {
+		_inclusionThreadCount = count;
+	}
+
+	// How deep blocks and inline styles may nest, parsing stops with an error past it.
+	// Quotes in quotes and styles in styles do not recurse, any maximum is safe for them.
+	// Blocks in list items, definitions and admonitions do, a level takes up to a kilobyte of
+	// stack, so a maximum far past the default wants a thread with a larger stack.
+	void setMaximumDepth(size_t depth) {
+		_maximumDepth = depth;
+	}
+
+	// By default the parser drives the lexer, tokens are lexed as the parser reaches them
+	// and let go of after each top-level block, so no token array for the whole content is built.
+	// A nonzero count lexes the whole content first on that many threads, then parses the tokens.
+	// Streamed input is always lexed as it is parsed.
+	void setLexingThreadCount(size_t count) {
+		_lexingThreadCount = count;
+	}
+
 private:
+	void _deduceWorkspaceFolder(std::string_view path) {
+		if (!_workspaceFolder.empty()) {
+			return;
+		}
+
+		_workspaceFolder = _folderOf(path);
+		_workspaceFolderDeduced = true;
+	}
+
+	static std::string _folderOf(std::string_view path) {
+		for (size_t i = path.size(); i > 1; i -= 1) {
+			if (path[i - 1] == '/') {
+				return std::string(path.data(), i - 1);
+			}
+		}
+
+		return ".";
+	}
+
+	static std::string _canonicalOrSame(const std::string& path) {
+		std::string canonicalPath = IncludeCache::canonicalOf(path);
+
+		return canonicalPath.empty() ? path : canonicalPath;
+	}
+
+	void _prepare() {
+		reset();
+
+		if (_document == nullptr) {
+			_document = new Document();
+		}
+	}
+
 	Document* _parse(std::string_view content) {
-		_lexer.parse(content);
+		if (content.size() > Lexer::maximumContentSize) {
+			Diagnostic diagnostic(Diagnostic::Code::tooLarge, _document->path, Range { 0, 0 });
+			diagnostic.limit = Lexer::maximumContentSize;
+			_report(std::move(diagnostic));
+			_error = true;
+			return _document;
+		}
+
+		_document->lineIndex.assign(content);
+		_document->sizeHint.textSize += content.size();
+
+		if (_lexingThreadCount == 0) {
+			_lexer.stream(content);
+		} else {
+			_lexer.parse(content, _lexingThreadCount);
+		}
+
+		_tokenIndex = 0;
+		_depth = 0;
+
+		#ifndef __EMSCRIPTEN__
+		if (_fileInclusion && _inclusionThreadCount > 1) {
+			_prefetchInclusions(content);
+		}
+		#endif
+
+		_parseDocumentAnnotation();
+
+		while (_isBound(0)) {
+			// a block only rewinds within itself, the tokens behind it are done
+			_lexer.discard(_tokenIndex);
+
+			Node* node = _parseAnnotatedBlock();
+
+			// a block that went wrong halfway is dropped
+			if (_error) {
+				return _document;
+			}
+
+			if (node == nullptr) {
+				if (_stopped) {
+					return _document;
+				}
+
+				_advance(1);
+				continue;
+			}
+
+			_document->children.push_back(node, _document->arena);
+		}
+
+		if (_document && !_document->children.empty()) {
+			_updateEndRange(_document->range, _document->children.back()->range);
+		}
+
+		return _document;
+	}
+
+	Document* _parseStream(Lexer::Reader reader, const BlockHandler& handler) {
+		_lexer.stream(std::move(reader));
 		_tokenIndex = 0;
+		_depth = 0;
+		_window = std::string_view();
+
+		_parseDocumentAnnotation();
+
+		// the window moves on, the document keeps its own copy of the annotations
+		size_t annotationSize = 0;
+
+		for (const Pair& annotation : _document->annotations) {
+			annotationSize += annotation.key.size() + annotation.value.size();
+		}
+
+		_document->content.reserve(annotationSize);
+
+		for (Pair& annotation : _document->annotations) {
+			annotation.key = _keepContent(annotation.key);
+			annotation.value = _keepContent(annotation.value);
+		}
+
+		// the annotations stay in the arena, the blocks after them are released one by one
+		Arena::Mark blockMark = _document->arena.mark();
+
+		while (_isBound(0)) {
+			// the previous block is gone, the input behind this one may be dropped
+			_lexer.discard(_tokenIndex);
+
+			Node* node = _parseAnnotatedBlock();
+
+			// a block that went wrong halfway is dropped
+			if (_error) {
+				return _document;
+			}
+
+			if (node == nullptr) {
+				if (_stopped) {
+					return _document;
+				}
+
+				_advance(1);
+				continue;
+			}
+
+			_updateEndRange(_document->range, node->range);
 
-		// // TOKENS //
-		// for (size_t i = 0; i < _lexer.size(); i += 1) {
-		// 	std::cout << (_lexer[i].range.startLine + 1) << "," << (_lexer[i].range.startColumn + 1) << "-";
-		// 	std::cout << (_lexer[i].range.endLine + 1) << "," << (_lexer[i].range.endColumn + 1) << " ";
-		// 	std::cout << TokenKindHelper::toStringView(_lexer[i].kind) << " " << _lexer[i].content << "\n";
-		// }
-		// return nullptr;
+			// a refill changes the window, the line starts are collected again on the next lookup
+			std::string_view window = _lexer.window();
 
+			if (window.data() != _window.data() || window.size() != _window.size()) {
+				_window = window;
+				_document->lineIndex.assign(window, _lexer.base(), _lexer.baseLine());
+			}
+
+			handler(*_document, node);
+			_document->arena.rewind(blockMark);
+		}
+
+		return _document;
+	}
+
+	static Lexer::Reader _readerOf(std::istream& stream) {
+		return [&stream](char* buffer, size_t size) {
+			stream.read(buffer, size);
+			return static_cast<size_t>(stream.gcount());
+		};
+	}
+
+	// the content must have enough capacity reserved, a reallocation would move the kept views
+	std::string_view _keepContent(std::string_view content) {
+		size_t index = _document->content.size();
+		_document->content.append(content);
+
+		return std::string_view(_document->content.data() + index, content.size());
+	}
+
+	void _parseDocumentAnnotation() {
 		_firstNode = true;
 
 		while (_isBound(0) && (_get(0).kind == TokenKind::newline || _get(0).kind == TokenKind::newlinePlus)) {
@@ -93,152 +406,210 @@ private:
 
 			if (_isBound(0) && (_get(0).kind == TokenKind::newline || _get(0).kind == TokenKind::newlinePlus)) {
 				if (!_annotations.empty() && _firstNode) {
-					_document->annotations = std::move(_annotations);
+					_takeAnnotations(_document);
 				}
 
 				_advance(1);
 			}
 		}
+	}
 
-		while (_isBound(0)) {
-			Node* node = _parseAnnotatedBlock();
-			if (node == nullptr) {
-				if (_error || _stopped) {
-					return _document;
-				}
+	// the nodes live in the arena of the document, a node that is given up on is released with the rest
+	template <typename T, typename... Arguments>
+	T* _create(Arguments&&... arguments) {
+		// a document is the only node the arena has to destroy
+		static_assert(std::is_trivially_destructible_v<T> || std::is_same_v<T, Document>);
 
-				_advance(1);
-				continue;
-			}
+		T* node = _document->arena.create<T>(std::forward<Arguments>(arguments)...);
+		_document->sizeHint.count(node->kind);
 
-			_document->children.push_back(node);
+		return node;
+	}
+
+	void _takeAnnotations(Node* node) {
+		node->annotations.assign(_annotations.data(), _annotations.size(), _document->arena);
+		_annotations.clear();
+	}
+
+	// Opens a level of nesting, false when it would go past the maximum depth.
+	bool _enter() {
+		if (_depth == _maximumDepth) {
+			_tooDeep(_maximumDepth);
+			return false;
 		}
 
-		if (_document && !_document->children.empty()) {
-			_updateEndRange(_document->range, _document->children.back()->range);
+		_depth += 1;
+
+		return true;
+	}
+
+	// every diagnostic goes through here
+	void _report(Diagnostic diagnostic) {
+		_diagnostics.push_back(std::move(diagnostic));
+
+		if (_diagnosticHandler) {
+			_diagnosticHandler(_diagnostics.back());
 		}
+	}
 
-		return _document;
+	// a diagnostic about the current token, or the end when there is none
+	Diagnostic _diagnostic(Diagnostic::Code code) {
+		return Diagnostic(code, _document->path, _range(_get(0)));
+	}
+
+	decltype(nullptr) _tooDeep(size_t depth) {
+		Diagnostic diagnostic = _diagnostic(Diagnostic::Code::tooDeep);
+		diagnostic.limit = depth;
+		_report(std::move(diagnostic));
+		_error = true;
+		return nullptr;
 	}
 
 	decltype(nullptr) _wrong(std::string_view message) {
-		std::cout << "[ParsingError] " << message << "\n";
+		Diagnostic diagnostic = _diagnostic(Diagnostic::Code::message);
+		diagnostic.detail = message;
+		_report(std::move(diagnostic));
 		return nullptr;
 	}
 
 	decltype(nullptr) _expect(std::string_view message) {
-		if (!_isBound(0)) {
-			std::cout << "[ParsingError] unxpected end of file, expect " << message << "\n";
+		// the callers unwinding from a reported error do not report it again
+		if (_error) {
 			return nullptr;
 		}
 
-		std::string_view kind = TokenKindHelper::toStringView(_get(0).kind);
-		std::cout << "[ParsingError] unxpected token " << kind << ", expect " << message << "\n";
+		// the messages are literals, they outlive the diagnostic
+		Diagnostic diagnostic = _diagnostic(_isBound(0) ? Diagnostic::Code::unexpectedToken : Diagnostic::Code::unexpectedEnd);
+		diagnostic.token = _get(0).kind;
+		diagnostic.expected = message;
+		_report(std::move(diagnostic));
 		return nullptr;
 	}
 
-	bool _isBound(size_t offset) const {
-		return _tokenIndex + offset < _lexer.size();
+	bool _isBound(size_t offset) {
+		return _lexer.fetch(_tokenIndex + offset);
 	}
 
 	void _advance(size_t offset) {
 		_tokenIndex += offset;
 	}
 
-	const Token& _get(size_t offset) const {
-		return _lexer[_tokenIndex + offset];
+	Token _get(size_t offset) {
+		return _lexer.get(_tokenIndex + offset);
 	}
 
-	const Token& _eat() {
+	Token _eat() {
 		_tokenIndex += 1;
-		return _lexer[_tokenIndex - 1];
+		return _lexer.get(_tokenIndex - 1);
 	}
 
-	Node* _parseEmphasis(Emphasis::Type type) {
-		const Token& token = _eat();
-		Emphasis* style = new Emphasis(token.range, type);
+	Range _range(const Token& token) const {
+		return _lexer.range(token);
+	}
 
-		while (_isBound(0) && _get(0).kind != token.kind) {
-			Node* child = _parseInline();
+	std::string_view _content(const Token& token) const {
+		return _lexer.content(token);
+	}
 
-			if (child == nullptr) {
-				delete style;
-				return nullptr;
-			}
+	struct Style {
+		Node* node;
+		TokenKind closingKind;
+	};
 
-			style->children.push_back(child);
-		}
+	bool _isStyleOpen(TokenKind kind) {
+		switch (kind) {
+			case TokenKind::asterisk:
+			case TokenKind::slash:
+			case TokenKind::underscore:
+			case TokenKind::highlightOpen:
+			case TokenKind::addOpen:
+			case TokenKind::removeOpen:
+				return true;
 
-		if (_isBound(0) && _get(0).kind != token.kind) {
-			delete style;
-			return _expect("asterisk");
+			default:
+				return false;
 		}
+	}
 
-		_updateEndRange(style->range, _get(0).range);
-		_advance(1);
+	Style _openStyle() {
+		Token token = _eat();
 
-		return style;
-	}
+		switch (token.kind) {
+			case TokenKind::asterisk:
+				return { _create<Emphasis>(_range(token), Emphasis::Type::bold), token.kind };
 
-	Node* _parseHighlight() {
-		const Token& token = _eat();
-		Highlight* highlight = new Highlight(token.range);
+			case TokenKind::slash:
+				return { _create<Emphasis>(_range(token), Emphasis::Type::italic), token.kind };
 
-		while (_isBound(0) && _get(0).kind != TokenKind::highlightClose) {
-			Node* child = _parseInline();
+			case TokenKind::underscore:
+				return { _create<Emphasis>(_range(token), Emphasis::Type::underline), token.kind };
 
-			if (child == nullptr) {
-				delete highlight;
-				return nullptr;
-			}
+			case TokenKind::highlightOpen:
+				return { _create<Highlight>(_range(token)), TokenKind::highlightClose };
 
-			highlight->children.push_back(child);
-		}
+			case TokenKind::addOpen:
+				return { _create<Change>(_range(token), Change::Type::added), TokenKind::addClose };
 
-		if (_isBound(0) && _get(0).kind != TokenKind::highlightClose) {
-			delete highlight;
-			return _expect("closing highlight");
+			default:
+				return { _create<Change>(_range(token), Change::Type::removed), TokenKind::removeClose };
 		}
+	}
 
-		_updateEndRange(highlight->range, _get(0).range);
-		_advance(1);
+	// Emphasis, highlight and change hold inline content, a style inside a style is
+	// pushed on _styles instead of the call stack so a deep run of them does not recurse.
+	Node* _parseStyle() {
+		size_t base = _styles.size();
+		size_t depth = _depth;
+
+		while (true) {
+			if (_styles.size() == base || (_isBound(0) && _isStyleOpen(_get(0).kind) && _get(0).kind != _styles.back().closingKind)) {
+				if (!_enter()) {
+					_styles.resize(base);
+					_depth = depth;
+					return nullptr;
+				}
 
-		return highlight;
-	}
+				_styles.push_back(_openStyle());
+				continue;
+			}
 
-	Node* _parseChange(Change::Type type, TokenKind closingKind) {
-		Change* change = new Change(_eat().range, type);
+			Style style = _styles.back();
 
-		while (_isBound(0) && _get(0).kind != closingKind) {
-			Node* child = _parseInline();
+			if (_isBound(0) && _get(0).kind != style.closingKind) {
+				Node* child = _parseInline();
 
-			if (child == nullptr) {
-				delete change;
-				return nullptr;
+				if (child == nullptr) {
+					_styles.resize(base);
+					_depth = depth;
+					return nullptr;
+				}
+
+				style.node->children.push_back(child, _document->arena);
+				continue;
 			}
 
-			change->children.push_back(child);
-		}
+			_updateEndRange(style.node->range, _range(_get(0)));
+			_advance(1);
 
-		if (_isBound(0) && _get(0).kind != closingKind) {
-			delete change;
-			return _expect("closing change");
-		}
+			_styles.pop_back();
+			_depth -= 1;
 
-		_updateEndRange(change->range, _get(0).range);
-		_advance(1);
+			if (_styles.size() == base) {
+				return style.node;
+			}
 
-		return change;
+			_styles.back().node->children.push_back(style.node, _document->arena);
+		}
 	}
 
 	Node* _parseComment() {
-		const Token& token = _eat();
-		return new Comment(token.range, token.content);
+		Token token = _eat();
+		return _create<Comment>(_range(token), _content(token));
 	}
 
 	Node* _parseText() {
-		const Token& token = _eat();
-		return new Text(token.range, token.content);
+		Token token = _eat();
+		return _create<Text>(_range(token), _content(token));
 	}
 
 	Node* _parseInline() {
@@ -253,31 +624,16 @@ private:
 				break;
 
 			case TokenKind::asterisk: 
-				node = _parseEmphasis(Emphasis::Type::bold);
-				break;
-
 			case TokenKind::slash: 
-				node = _parseEmphasis(Emphasis::Type::italic);
-				break;
-
 			case TokenKind::underscore: 
-				node = _parseEmphasis(Emphasis::Type::underline);
-				break;
-
 			case TokenKind::highlightOpen: 
-				node = _parseHighlight();
-				break;
-
 			case TokenKind::addOpen: 
-				node = _parseChange(Change::Type::added, TokenKind::addClose);
-				break;
-
 			case TokenKind::removeOpen: 
-				node = _parseChange(Change::Type::removed, TokenKind::removeClose);
+				node = _parseStyle();
 				break;
 
 			case TokenKind::lineBreak: 
-				node = new LineBreak(_eat().range);
+				node = _create<LineBreak>(_range(_eat()));
 				break;
 
 			case TokenKind::backtick: 
@@ -311,39 +667,39 @@ private:
 			       break;
 
 			case TokenKind::hyphen: 
-			       node = new Punct(_eat().range, Punct::Type::hypen);
+			       node = _create<Punct>(_range(_eat()), Punct::Type::hypen);
 			       break;
 
 			case TokenKind::enDash: 
-			       node = new Punct(_eat().range, Punct::Type::enDash);
+			       node = _create<Punct>(_range(_eat()), Punct::Type::enDash);
 			       break;
 
 			case TokenKind::emDash: 
-			       node = new Punct(_eat().range, Punct::Type::emDash);
+			       node = _create<Punct>(_range(_eat()), Punct::Type::emDash);
 			       break;
 
 			case TokenKind::quoteOpen: 
-			       node = new Punct(_eat().range, Punct::Type::quoteOpen);
+			       node = _create<Punct>(_range(_eat()), Punct::Type::quoteOpen);
 			       break;
 
 			case TokenKind::quoteClose: 
-			       node = new Punct(_eat().range, Punct::Type::quoteClose);
+			       node = _create<Punct>(_range(_eat()), Punct::Type::quoteClose);
 			       break;
 
 			case TokenKind::squoteOpen: 
-			       node = new Punct(_eat().range, Punct::Type::squoteOpen);
+			       node = _create<Punct>(_range(_eat()), Punct::Type::squoteOpen);
 			       break;
 
 			case TokenKind::squoteClose: 
-			       node = new Punct(_eat().range, Punct::Type::squoteClose);
+			       node = _create<Punct>(_range(_eat()), Punct::Type::squoteClose);
 			       break;
 
 			case TokenKind::accountTag: 
-			       node = new AccountTag(_get(0).range, _eat().content);
+			       node = _create<AccountTag>(_range(_get(0)), _content(_eat()));
 			       break;
 
 			case TokenKind::hashTag: 
-			       node = new HashTag(_get(0).range, _eat().content);
+			       node = _create<HashTag>(_range(_get(0)), _content(_eat()));
 			       break;
 
 			case TokenKind::colon: 
@@ -358,10 +714,10 @@ private:
 	}
 
 	Node* _parseParagraph() {
-		const Token& token = _get(0);
+		Token token = _get(0);
 		size_t previousTokenIndex = _tokenIndex;
 
-		Paragraph* paragraph = new Paragraph(token.range);
+		Paragraph* paragraph = _create<Paragraph>(_range(token));
 		bool newline = false;
 
 		Node* view = nullptr;
@@ -376,7 +732,6 @@ private:
 			if (node == nullptr) {
 				if (_get(0).kind == TokenKind::equal) {
 					if (!newline) {
-						delete paragraph;
 						_tokenIndex = previousTokenIndex;
 						return _parseDefinitionList();
 					} else {
@@ -392,11 +747,10 @@ private:
 
 						Node* indent = _parseIndent();
 						if (indent == nullptr) {
-							delete paragraph;
 							return nullptr;
 						}
 
-						paragraph->children.push_back(indent);
+						paragraph->children.push_back(indent, _document->arena);
 						continue;
 					}
 
@@ -405,8 +759,8 @@ private:
 						continue;
 					}
 
-					const Token& token = _eat();
-					paragraph->children.push_back(new Space(token.range));
+					Token token = _eat();
+					paragraph->children.push_back(_create<Space>(_range(token)), _document->arena);
 					continue;
 				}
 
@@ -427,7 +781,7 @@ private:
 					break;
 			}
 
-			paragraph->children.push_back(node);
+			paragraph->children.push_back(node, _document->arena);
 		}
 
 		if (_get(0).kind == TokenKind::newlinePlus) {
@@ -440,7 +794,6 @@ private:
 				Node* blockView = view;
 				blockView->children = std::move(paragraph->children);
 				blockView->children.erase(blockView->children.begin() + viewIndex);
-				delete paragraph;
 				return blockView;
 			} else { // comments only
 				if (_annotations.empty()) {
@@ -467,8 +820,8 @@ private:
 	}
 
 	Node* _parseHeading() {
-		const Token& token = _get(0);
-		Heading* heading = new Heading(token.range);
+		Token token = _get(0);
+		Heading* heading = _create<Heading>(_range(token));
 
 		switch (token.kind) {
 			case TokenKind::head3:
@@ -492,7 +845,7 @@ private:
 			return heading;
 		}
 
-		heading->children.push_back(title);
+		heading->children.push_back(title, _document->arena);
 
 		int currentValue = getHeadValue(token.kind);
 
@@ -514,7 +867,7 @@ private:
 				return nullptr;
 			}
 
-			heading->children.push_back(node);
+			heading->children.push_back(node, _document->arena);
 		}
 
 		end:
@@ -527,13 +880,13 @@ private:
 	}
 
 	Node* _parseTitle() {
-		const Token& token = _eat();
-		Title* title = new Title(token.range);
+		Token token = _eat();
+		Title* title = _create<Title>(_range(token));
 
 		while (_isBound(0)) {
 			if (_get(0).kind == TokenKind::colon) {
-				Subtitle* subtitle = new Subtitle(_get(0).range);
-				title->children.push_back(subtitle);
+				Subtitle* subtitle = _create<Subtitle>(_range(_get(0)));
+				title->children.push_back(subtitle, _document->arena);
 				_advance(1);
 
 				while (_isBound(0)) {
@@ -553,7 +906,7 @@ private:
 						return _expect("newline or block");
 					}
 
-					subtitle->children.push_back(node);
+					subtitle->children.push_back(node, _document->arena);
 				}
 
 				return title;
@@ -572,11 +925,10 @@ private:
 					break;
 				}
 
-				delete title;
 				return _expect("newline or block");
 			}
 
-			title->children.push_back(node);
+			title->children.push_back(node, _document->arena);
 		}
 
 		if (title && !title->children.empty()) {
@@ -587,8 +939,8 @@ private:
 	}
 
 	Node* _parseSubtitle() {
-		const Token& token = _eat();
-		Subtitle* subtitle = new Subtitle(token.range);
+		Token token = _eat();
+		Subtitle* subtitle = _create<Subtitle>(_range(token));
 
 		while (_isBound(0)) {
 			Node* node = _parseInline();
@@ -603,11 +955,10 @@ private:
 					break;
 				}
 
-				delete subtitle;
 				return _expect("newline or block");
 			}
 
-			subtitle->children.push_back(node);
+			subtitle->children.push_back(node, _document->arena);
 		}
 
 		if (subtitle && !subtitle->children.empty()) {
@@ -617,40 +968,81 @@ private:
 		return subtitle;
 	}
 
+	// A quote right inside a quote is pushed on _quotes instead of the call stack,
+	// so a deep indentation does not recurse.
 	Node* _parseIndent() {
-		const Token& token = _eat();
-		Quote* indent = new Quote(token.range);
+		size_t base = _quotes.size();
+		size_t depth = _depth;
 
-		while (_isBound(0) && _get(0).kind != TokenKind::indentClose) {
-			Node* node = _parseAnnotatedBlock();
+		_quotes.push_back(_create<Quote>(_range(_eat())));
 
-			if (node == nullptr) {
-				delete indent;
-				return nullptr;
+		while (true) {
+			Quote* indent = _quotes.back();
+
+			if (_isBound(0) && _get(0).kind != TokenKind::indentClose) {
+				if (_get(0).kind == TokenKind::indentOpen) {
+					if (!_enter()) {
+						_quotes.resize(base);
+						_depth = depth;
+						return nullptr;
+					}
+
+					_quotes.push_back(_create<Quote>(_range(_eat())));
+					continue;
+				}
+
+				Node* node = _parseAnnotatedBlock();
+
+				if (node == nullptr) {
+					_quotes.resize(base);
+					_depth = depth;
+					return nullptr;
+				}
+
+				indent->children.push_back(node, _document->arena);
+				continue;
 			}
 
-			indent->children.push_back(node);
-		}
+			if (!(_isBound(0) && _get(0).kind == TokenKind::indentClose)) {
+				_quotes.resize(base);
+				_depth = depth;
+				return _expect("indent pop");
+			}
 
-		if (!(_isBound(0) && _get(0).kind == TokenKind::indentClose)) {
-			return _expect("indent pop");
-		}
+			_advance(1);
 
-		_advance(1);
+			if (_isBound(0) && (_get(0).kind == TokenKind::newline || _get(0).kind == TokenKind::newlinePlus)) {
+				_eat();
+			}
 
-		if (_isBound(0) && (_get(0).kind == TokenKind::newline || _get(0).kind == TokenKind::newlinePlus)) {
-			_eat();
-		}
+			if (!indent->children.empty()) {
+				_updateEndRange(indent->range, indent->children.back()->range);
+			}
 
-		if (indent && !indent->children.empty()) {
-			_updateEndRange(indent->range, indent->children.back()->range);
-		}
+			_quotes.pop_back();
+
+			if (_quotes.size() == base) {
+				return indent;
+			}
+
+			// the inner quote is a block of the outer one, finish it the way _parseAnnotatedBlock does
+			_depth -= 1;
+			_firstNode = false;
 
-		return indent;
+			if (!_annotations.empty()) {
+				_takeAnnotations(indent);
+			}
+
+			if (_isBound(0) && (_get(0).kind == TokenKind::newline || _get(0).kind == TokenKind::newlinePlus)) {
+				_advance(1);
+			}
+
+			_quotes.back()->children.push_back(indent, _document->arena);
+		}
 	}
 
 	Node* _parsePageBreak() {
-		Node* node = new PageBreak(_eat().range);
+		Node* node = _create<PageBreak>(_range(_eat()));
 
 		if (_isBound(0) && (_get(0).kind == TokenKind::newline || _get(0).kind == TokenKind::newlinePlus)) {
 			_advance(1);
@@ -660,7 +1052,7 @@ private:
 	}
 
 	Node* _parseDinkus() {
-		Node* node = new Dinkus(_eat().range);
+		Node* node = _create<Dinkus>(_range(_eat()));
 
 		if (_isBound(0) && (_get(0).kind == TokenKind::newline || _get(0).kind == TokenKind::newlinePlus)) {
 			_advance(1);
@@ -696,7 +1088,7 @@ private:
 								return ItemResult::error;
 							}
 
-							item->children.push_back(subnode);
+							item->children.push_back(subnode, _document->arena);
 						}
 
 						break;
@@ -714,18 +1106,18 @@ private:
 				return ItemResult::earlyExit;
 			}
 
-			item->children.push_back(node);
+			item->children.push_back(node, _document->arena);
 		}
 
 		return ItemResult::ok;
 	}
 
 	Node* _parseList(TokenKind tokenKind, NodeKind nodeKind) {
-		List* list = new List(_get(0).range, nodeKind);
+		List* list = _create<List>(_range(_get(0)), nodeKind);
 
 		while (_isBound(0) && _get(0).kind == tokenKind) {
-			Item* item = new Item(_eat().range);
-			list->children.push_back(item);
+			Item* item = _create<Item>(_range(_eat()));
+			list->children.push_back(item, _document->arena);
 
 			ItemResult result = _parseItem(list, item);
 
@@ -736,7 +1128,6 @@ private:
 			switch (result) {
 				case ItemResult::ok: break;
 				case ItemResult::error: 
-					delete list;
 					return nullptr;
 				case ItemResult::earlyExit: goto listEnd;
 			}
@@ -752,14 +1143,14 @@ private:
 	}
 
 	Node* _parseCheckList() {
-		List* list = new List(_get(0).range, NodeKind::checkList);
+		List* list = _create<List>(_range(_get(0)), NodeKind::checkList);
 
 		while (_isBound(0) && _get(0).kind == TokenKind::checkbox) {
-			const Token& token = _eat();
-			CheckItem* item = new CheckItem(token.range);
-			list->children.push_back(item);
+			Token token = _eat();
+			CheckItem* item = _create<CheckItem>(_range(token));
+			list->children.push_back(item, _document->arena);
 
-			switch (token.content[1]) {
+			switch (_content(token)[1]) {
 				case ' ': item->checked = false; break;
 				case 'x': item->checked = true; break;
 			}
@@ -773,7 +1164,6 @@ private:
 			switch (result) {
 				case ItemResult::ok: break;
 				case ItemResult::error:
-					delete list;
 					return nullptr;
 				case ItemResult::earlyExit: goto listEnd;
 			}
@@ -789,17 +1179,16 @@ private:
 	}
 
 	Node* _parseDefinitionList() {
-		List* list = new List(_get(0).range, NodeKind::definitionList);
+		List* list = _create<List>(_range(_get(0)), NodeKind::definitionList);
 
 		while (_isBound(0) && _isParagraph()) {
 			// size_t previousTokenIndex = _tokenIndex;
-			bool itemOccupied = false;
 			bool itemEqual = false;
 
-			DefinitionItem* item = new DefinitionItem(_get(0).range);
-			DefinitionTerm* term = new DefinitionTerm(_get(0).range);
+			DefinitionItem* item = _create<DefinitionItem>(_range(_get(0)));
+			DefinitionTerm* term = _create<DefinitionTerm>(_range(_get(0)));
 
-			item->children.push_back(term);
+			item->children.push_back(term, _document->arena);
 
 			while (_isBound(0) && _isParagraph()) {
 				Node* node = _parseInline();
@@ -807,15 +1196,12 @@ private:
 				if (node == nullptr) {
 					if (_get(0).kind == TokenKind::newlinePlus) {
 						_advance(1);
-						if (!itemOccupied) {
-							delete item;
-						}
 						goto listEnd;
 					}
 
 					if (_get(0).kind == TokenKind::equal) {
-						DefinitionDesc* desc = new DefinitionDesc(_eat().range);
-						item->children.push_back(desc);
+						DefinitionDesc* desc = _create<DefinitionDesc>(_range(_eat()));
+						item->children.push_back(desc, _document->arena);
 						itemEqual = true;
 
 						while (_isBound(0)) {
@@ -837,7 +1223,7 @@ private:
 												return list;
 											}
 
-											desc->children.push_back(subnode);
+											desc->children.push_back(subnode, _document->arena);
 										}
 
 										goto itemEnd;
@@ -849,11 +1235,11 @@ private:
 
 								if (_get(0).kind == TokenKind::newlinePlus) {
 									_advance(1);
-									list->children.push_back(item);
+									list->children.push_back(item, _document->arena);
 									goto listEnd;
 								}
 							}
-							desc->children.push_back(node);
+							desc->children.push_back(node, _document->arena);
 						}
 					}
 					break;
@@ -861,14 +1247,13 @@ private:
 
 				revalidateNode:
 
-				term->children.push_back(node);
-				itemOccupied = true;
+				term->children.push_back(node, _document->arena);
 			}
 
 			itemEnd:
 
 			if (itemEqual) {
-				list->children.push_back(item);
+				list->children.push_back(item, _document->arena);
 
 				if (!item->children.empty()) {
 					_updateEndRange(item->children.front()->range, item->children.front()->children.back()->range);
@@ -904,12 +1289,12 @@ private:
 	}
 
 	Node* _parseTable() {
-		Table* table = new Table(_get(0).range);
+		Table* table = _create<Table>(_range(_get(0)));
 
 		Row::Type type = Row::Type::header;
 
 		while (_isBound(0) && _get(0).kind == TokenKind::pipe) {
-			const Token& token = _eat();
+			Token token = _eat();
 
 			if (_isBound(0) && (_get(0).kind == TokenKind::tee || _get(0).kind == TokenKind::teeLeft || _get(0).kind == TokenKind::teeCenter || _get(0).kind == TokenKind::teeRight)) {
 				while (_isBound(0)) {
@@ -922,21 +1307,21 @@ private:
 							case TokenKind::teeLeft:
 								_advance(1);
 								if (type == Row::Type::header) {
-									table->alignments.push_back(Table::Alignment::left);
+									table->alignments.push_back(Table::Alignment::left, _document->arena);
 								}
 								goto nextTeeCell;
 
 							case TokenKind::teeCenter:
 								_advance(1);
 								if (type == Row::Type::header) {
-									table->alignments.push_back(Table::Alignment::center);
+									table->alignments.push_back(Table::Alignment::center, _document->arena);
 								}
 								goto nextTeeCell;
 
 							case TokenKind::teeRight:
 								_advance(1);
 								if (type == Row::Type::header) {
-									table->alignments.push_back(Table::Alignment::right);
+									table->alignments.push_back(Table::Alignment::right, _document->arena);
 								}
 								goto nextTeeCell;
 
@@ -970,12 +1355,12 @@ private:
 				continue;
 			}
 
-			Row* row = new Row(token.range);
+			Row* row = _create<Row>(_range(token));
 			row->type = type;
-			table->children.push_back(row);
+			table->children.push_back(row, _document->arena);
 
 			while (_isBound(0)) {
-				Cell* cell = new Cell(_get(0).range);
+				Cell* cell = _create<Cell>(_range(_get(0)));
 
 				while (_isBound(0)) {
 					Node* node = _parseInline();
@@ -987,19 +1372,16 @@ private:
 
 							case TokenKind::newline:
 								_advance(1);
-								delete cell;
 								goto nextRow;
 
 							case TokenKind::newlinePlus:
 								_advance(1);
-								delete cell;
 								if (row && !row->children.empty()) {
 									_updateEndRange(row->range, row->children.back()->range);
 								}
 								goto returnWithCheck;
 								
 							default:
-								delete cell;
 								if (row && !row->children.empty()) {
 									_updateEndRange(row->range, row->children.back()->range);
 								}
@@ -1007,15 +1389,15 @@ private:
 						}
 					}
 
-					cell->children.push_back(node);
+					cell->children.push_back(node, _document->arena);
 				}
 
 				nextCell:
-				row->children.push_back(cell);
+				row->children.push_back(cell, _document->arena);
 
 				if (cell && !cell->children.empty()) {
 					_updateEndRange(cell->range, cell->children.back()->range);
-					cell->range.endColumn += 1; // account for pipe
+					cell->range.end += 1; // account for pipe
 				}
 			}
 
@@ -1040,15 +1422,15 @@ private:
 
 
 	Node* _parseLink() {
-		Link* link = new Link(_eat().range);
-		Range rangeEnd;
+		Link* link = _create<Link>(_range(_eat()));
+		Range rangeEnd = link->range;
 
 		if (_isBound(0) && _get(0).kind == TokenKind::raw) {
-			link->setResource(_eat().content);
+			link->setResource(_content(_eat()), _document->arena);
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareClose) {
-			rangeEnd = _get(0).range;
+			rangeEnd = _range(_get(0));
 			_advance(1);
 
 			if (_isBound(0) && _get(0).kind == TokenKind::parenOpen) {
@@ -1056,12 +1438,11 @@ private:
 					_get(1).kind == TokenKind::raw && 
 					_get(2).kind == TokenKind::parenClose) {
 
-					link->label = _get(1).content;
+					link->label = _content(_get(1));
 
-					rangeEnd = _get(2).range;
+					rangeEnd = _range(_get(2));
 					_advance(3);
 				} else {
-					delete link;
 					return nullptr;
 				}
 			}
@@ -1073,19 +1454,19 @@ private:
 	}
 
 	Node* _parseView() {
-		View* view = new View(_eat().range);
-		Range rangeEnd;
+		View* view = _create<View>(_range(_eat()));
+		Range rangeEnd = view->range;
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareOpen) {
 			_advance(1);
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::raw) {
-			view->resource = _eat().content;
+			view->resource = _content(_eat());
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareClose) {
-			rangeEnd = _get(0).range;
+			rangeEnd = _range(_get(0));
 			_advance(1);
 
 			if (_isBound(0) && _get(0).kind == TokenKind::parenOpen) {
@@ -1093,12 +1474,11 @@ private:
 					_get(1).kind == TokenKind::raw && 
 					_get(2).kind == TokenKind::parenClose) {
 
-					view->label = _get(1).content;
+					view->label = _content(_get(1));
 
-					rangeEnd = _get(2).range;
+					rangeEnd = _range(_get(2));
 					_advance(3);
 				} else {
-					delete view;
 					return nullptr;
 				}
 			}
@@ -1110,18 +1490,18 @@ private:
 	}
 
 	Node* _parseInText() {
-		InText* view = new InText(_eat().range);
+		InText* view = _create<InText>(_range(_eat()));
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareOpen) {
 			_advance(1);
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::raw) {
-			view->id = _eat().content;
+			view->id = _content(_eat());
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareClose) {
-			_updateEndRange(view->range, _get(0).range);
+			_updateEndRange(view->range, _range(_get(0)));
 			_advance(1);
 		}
 
@@ -1129,29 +1509,29 @@ private:
 	}
 
 	Node* _parseEmoji() {
-		const Token& token = _eat();
-		return new Emoji(token.range, token.content);
+		Token token = _eat();
+		return _create<Emoji>(_range(token), _content(token));
 	}
 
 	Node* _parseDateTime() {
-		const Token& token = _eat();
-		return new DateTime(token.range, token.content);
+		Token token = _eat();
+		return _create<DateTime>(_range(token), _content(token));
 	}
 
 	Node* _parseInclude() {
 		#ifdef __EMSCRIPTEN__
-		Link* link = new Link(_eat().range);
+		Link* link = _create<Link>(_range(_eat()));
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareOpen) {
 			_advance(1);
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::raw) {
-			link->resource = _eat().content;
+			link->resource = _content(_eat());
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareClose) {
-			_updateEndRange(link->range, _get(0).range);
+			_updateEndRange(link->range, _range(_get(0)));
 			_advance(1);
 		}
 
@@ -1163,48 +1543,45 @@ private:
 		#else
 
 		Document* document = nullptr;
-		const Token& token = _eat();
+		Token token = _eat();
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareOpen) {
 			_advance(1);
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::raw) {
-			std::string_view filePath = _eat().content;
-			std::string path = _workspaceFolder + std::string("/");
-			path.append(filePath);
+			std::string_view filePath = _content(_eat());
 
 			if (_fileInclusion) {
-				Parser parser;
+				std::string path = _workspaceFolder + std::string("/");
+				path.append(filePath);
+
 				if (std::filesystem::exists(path)) {
 					if (std::filesystem::is_directory(path)) {
-						std::cout << "inclusion failed because \"" << path << "\" is a folder\n";
-						_error = true;
+						_reportInclusion(Diagnostic::Code::inclusionFolder, path, _range(token));
 						return nullptr;
 					}
 
-					document = parser.parseFile(path);
+					document = _includeFile(path, _range(token));
 
 					if (document == nullptr) {
 						return nullptr;
 					}
 
-					document->range = token.range;
-					parser._document = nullptr;
+					document->range = _range(token);
 				} else {
-					std::cout << "inclusion failed because file \"" << path << "\" does not exists\n";
-					_error = true;
+					_reportInclusion(Diagnostic::Code::inclusionMissing, path, _range(token));
 					return nullptr;
 				}
 			} else {
-				document = new Document();
+				document = _create<Document>();
 				document->path = std::string(filePath.data(), filePath.size());
-				document->range = token.range;
+				document->range = _range(token);
 			}
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareClose) {
-			_updateEndRange(document->range, _get(0).range);
+			_updateEndRange(document->range, _range(_get(0)));
 			_advance(1);
 		}
 
@@ -1216,8 +1593,182 @@ private:
 		#endif
 	}
 
+	#ifndef __EMSCRIPTEN__
+	// the cache given to the parser, or its own while the inclusions of a document are prefetched
+	IncludeCache* _inclusionCache() {
+		if (_includeCache != nullptr) {
+			return _includeCache;
+		}
+
+		return _prefetched ? &_prefetchCache : nullptr;
+	}
+
+	// Parses the files the content includes ahead of the parse on the inclusion threads, into the
+	// cache the parse takes them from. The files are found by a look at the line starts, which may
+	// also catch one in a code block, it is then parsed for nothing. A file whose parse reports
+	// anything is not kept, the parse in turn reports it again where it would have anyway.
+	void _prefetchInclusions(std::string_view content) {
+		std::vector<std::string> paths;
+
+		size_t begin = 0;
+
+		while (begin < content.size()) {
+			size_t end = std::min(content.find('\n', begin), content.size());
+			std::string_view line = content.substr(begin, end - begin);
+			begin = end + 1;
+
+			size_t index = line.find_first_not_of(" \t");
+
+			if (index == std::string_view::npos || line.compare(index, 2, "?[") != 0) {
+				continue;
+			}
+
+			size_t close = line.find(']', index + 2);
+
+			if (close == std::string_view::npos) {
+				continue;
+			}
+
+			std::string path = _workspaceFolder + std::string("/");
+			path.append(line.substr(index + 2, close - index - 2));
+
+			if (std::find(paths.begin(), paths.end(), path) == paths.end()) {
+				paths.push_back(std::move(path));
+			}
+		}
+
+		if (paths.size() < 2) {
+			return;
+		}
+
+		if (_includeCache == nullptr) {
+			_prefetched = true;
+		}
+
+		IncludeCache* cache = _inclusionCache();
+		std::vector<std::string> chain = _chain();
+
+		Tasks::run(paths.size(), _inclusionThreadCount, [&](size_t index) {
+			IncludeCache::Key key;
+			std::error_code error;
+
+			if (!std::filesystem::is_regular_file(paths[index], error) || !IncludeCache::keyOf(IncludeCache::canonicalOf(paths[index]), _maximumDepth, key) || cache->contains(key)) {
+				return;
+			}
+
+			// a file the chain already has or one too deep is left to fail in turn
+			if (std::find(chain.begin(), chain.end(), key.path) != chain.end() || _inclusionDepth >= _maximumInclusionDepth) {
+				return;
+			}
+
+			Parser parser;
+			_inherit(parser, paths[index], chain);
+
+			if (parser.parseFile(paths[index]) != nullptr && parser._diagnostics.empty()) {
+				cache->insert(key, parser.release());
+			}
+		});
+	}
+
+	// the canonical paths of the files that are being parsed to include this one, and of this one
+	std::vector<std::string> _chain() {
+		std::vector<std::string> chain = _includers;
+
+		if (!_document->path.empty()) {
+			chain.push_back(_canonicalOrSame(_document->path));
+		}
+
+		return chain;
+	}
+
+	// an included file is parsed the way the including one is, one level further down
+	void _inherit(Parser& parser, const std::string& path, const std::vector<std::string>& chain) {
+		parser.setIncludeCache(_inclusionCache());
+		parser.setWorkspaceFolder(_folderOf(path));
+		parser.setMaximumDepth(_maximumDepth);
+		parser.setMaximumInclusionDepth(_maximumInclusionDepth);
+		parser._includers = chain;
+		parser._inclusionDepth = _inclusionDepth + 1;
+	}
+
+	// a failed inclusion stops the parse
+	void _reportInclusion(Diagnostic::Code code, const std::string& path, Range range) {
+		Diagnostic diagnostic(code, _document->path, range);
+		diagnostic.detail = path;
+		diagnostic.limit = _maximumInclusionDepth;
+		_report(std::move(diagnostic));
+		_error = true;
+	}
+
+	Document* _includeFile(const std::string& path, Range range) {
+		std::vector<std::string> chain = _chain();
+		std::string canonicalPath = _canonicalOrSame(path);
+
+		if (std::find(chain.begin(), chain.end(), canonicalPath) != chain.end()) {
+			_reportInclusion(Diagnostic::Code::inclusionCycle, path, range);
+			return nullptr;
+		}
+
+		if (_inclusionDepth >= _maximumInclusionDepth) {
+			_reportInclusion(Diagnostic::Code::inclusionTooDeep, path, range);
+			return nullptr;
+		}
+
+		IncludeCache* cache = _inclusionCache();
+		IncludeCache::Key key;
+		bool cacheable = cache != nullptr && IncludeCache::keyOf(canonicalPath, _maximumDepth, key);
+
+		if (cacheable) {
+			std::shared_ptr<const Document> origin = cache->find(key, chain, _maximumInclusionDepth - _inclusionDepth);
+
+			if (origin != nullptr) {
+				return _graft(path, std::move(origin));
+			}
+		}
+
+		Parser parser;
+		_inherit(parser, path, chain);
+		Document* document = parser.parseFile(path);
+
+		// what an included file reports is reported by the including one too, neither is kept then
+		for (Diagnostic& diagnostic : parser._diagnostics) {
+			_report(std::move(diagnostic));
+		}
+
+		bool reported = !parser._diagnostics.empty();
+
+		if (document == nullptr) {
+			return nullptr;
+		}
+
+		// a file that reported anything is parsed again next time, so it is reported again
+		if (!cacheable || reported) {
+			_document->sizeHint.add(document->sizeHint);
+			return _document->arena.adopt(parser.release().release());
+		}
+
+		std::shared_ptr<const Document> origin = parser.release();
+		cache->insert(key, origin);
+
+		return _graft(path, std::move(origin));
+	}
+
+	// a document of its own for every inclusion, the path and the range may differ, the children are shared
+	Document* _graft(const std::string& path, std::shared_ptr<const Document> origin) {
+		Document* document = _create<Document>();
+		document->path = path;
+		document->children.assign(origin->children.begin(), origin->children.size(), _document->arena);
+		document->annotations.assign(origin->annotations.begin(), origin->annotations.size(), _document->arena);
+		document->lineIndex.assign(origin->file.view());
+		_document->sizeHint.add(origin->sizeHint);
+		document->origin = std::move(origin);
+
+		return document;
+	}
+	#endif
+
 	Node* _parseFootnote() {
-		const Token& token = _eat();
+		Token token = _eat();
 		Footnote* ref = nullptr;
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareOpen) {
@@ -1225,11 +1776,11 @@ private:
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::raw) {
-			ref = new Footnote(token.range, _eat().content);
+			ref = _create<Footnote>(_range(token), _content(_eat()));
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::squareClose) {
-			_updateEndRange(ref->range, _get(0).range);
+			_updateEndRange(ref->range, _range(_get(0)));
 			_advance(1);
 		}
 
@@ -1237,7 +1788,7 @@ private:
 	}
 
 	Node* _parseReference() {
-		Reference* ref = new Reference(_get(0).range);
+		Reference* ref = _create<Reference>(_range(_get(0)));
 
 		_advance(1);
 
@@ -1245,7 +1796,7 @@ private:
 			return ref;
 		}
 
-		ref->id = _eat().content;
+		ref->id = _content(_eat());
 
 		if (!(_isBound(0) && _get(0).kind == TokenKind::newline)) {
 			return ref;
@@ -1260,7 +1811,7 @@ private:
 		_advance(1);
 
 		while (_isBound(0) && _get(0).kind == TokenKind::text) {
-			ReferenceInfo* info = new ReferenceInfo(_get(0).range, _get(0).content);
+			ReferenceInfo* info = _create<ReferenceInfo>(_range(_get(0)), _content(_get(0)));
 			_advance(1);
 
 			if (!(_isBound(0) && _get(0).kind == TokenKind::equal)) {
@@ -1271,7 +1822,7 @@ private:
 
 			while (_isBound(0)) {
 				if (_get(0).kind == TokenKind::indentClose) {
-					_updateEndRange(ref->range, _get(0).range);
+					_updateEndRange(ref->range, _range(_get(0)));
 					_advance(1);
 					goto end;
 				}
@@ -1280,20 +1831,20 @@ private:
 				if (node == nullptr) {
 					if (_isBound(0)) {
 						if (_get(0).kind == TokenKind::newline || _get(0).kind == TokenKind::newlinePlus) {
-							_updateEndRange(info->range, _get(0).range);
+							_updateEndRange(info->range, _range(_get(0)));
 							_advance(1);
 							break;
 						}
 					}
 					break;
 				}
-				info->children.push_back(node);
+				info->children.push_back(node, _document->arena);
 			}
 
-			ref->children.push_back(info);
+			ref->children.push_back(info, _document->arena);
 
 			if (_isBound(0) && _get(0).kind == TokenKind::indentClose) {
-				_updateEndRange(info->range, _get(0).range);
+				_updateEndRange(info->range, _range(_get(0)));
 				_advance(1);
 			}
 		}
@@ -1304,15 +1855,15 @@ private:
 	}
 
 	Node* _parseCode() {
-		Code* code = new Code(_eat().range);
-		Range endRange;
+		Code* code = _create<Code>(_range(_eat()));
+		Range endRange = code->range;
 
 		if (_isBound(0) && _get(0).kind == TokenKind::raw) {
-			code->content = _eat().content;
+			code->content = _content(_eat());
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::backtick) {
-			endRange = _get(0).range;
+			endRange = _range(_get(0));
 			_advance(1);
 
 			if (_isBound(2) && 
@@ -1321,9 +1872,9 @@ private:
 				_get(2).kind == TokenKind::backtick) {
 
 				code->label = code->content;
-				code->content = _get(1).content;
+				code->content = _content(_get(1));
 
-				endRange = _get(2).range;
+				endRange = _range(_get(2));
 				_advance(3);
 			}
 		}
@@ -1334,18 +1885,18 @@ private:
 	}
 
 	Node* _parseCodeBlock() {
-		CodeBlock* codeBlock = new CodeBlock(_eat().range);
+		CodeBlock* codeBlock = _create<CodeBlock>(_range(_eat()));
 
 		if (_isBound(0) && _get(0).kind == TokenKind::text) {
-			codeBlock->label = _eat().content;
+			codeBlock->label = _content(_eat());
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::raw) {
-			codeBlock->content = _eat().content;
+			codeBlock->content = _content(_eat());
 		}
 
 		if (_isBound(0) && _get(0).kind == TokenKind::fenceClose) {
-			_updateEndRange(codeBlock->range, _get(0).range);
+			_updateEndRange(codeBlock->range, _range(_get(0)));
 			_advance(1);
 
 			if (_isBound(0) && (_get(0).kind == TokenKind::newline || _get(0).kind == TokenKind::newlinePlus)) {
@@ -1357,14 +1908,14 @@ private:
 	}
 
 	Node* _parseAdmonition() {
-		const Token& token = _eat();
-		Admonition* admon = new Admonition(token.range);
+		Token token = _eat();
+		Admonition* admon = _create<Admonition>(_range(token));
 
 		if (!(_isBound(0) && _get(0).kind == TokenKind::admonitionLabel)) {
 			return admon;
 		}
 
-		admon->label = _eat().content;
+		admon->label = _content(_eat());
 
 		while (_isBound(0) && _isParagraph()) {
 			Node* node = _parseInline();
@@ -1372,7 +1923,7 @@ private:
 			if (node == nullptr) {
 				if (_get(0).kind == TokenKind::newline) {
 					if (_isBound(1) && _get(1).kind == TokenKind::indentOpen) {
-						admon->children.push_back(new Space(_get(0).range));
+						admon->children.push_back(_create<Space>(_range(_get(0))), _document->arena);
 						_advance(2);
 
 						while (_isBound(0)) {
@@ -1386,11 +1937,10 @@ private:
 									goto end;
 								}
 
-								delete admon;
 								return _expect("indent pop");
 							}
 
-							admon->children.push_back(subnode);
+							admon->children.push_back(subnode, _document->arena);
 						}
 
 						break;
@@ -1406,7 +1956,7 @@ private:
 				}
 			}
 
-			admon->children.push_back(node);
+			admon->children.push_back(node, _document->arena);
 		}
 
 		end:
@@ -1421,9 +1971,9 @@ private:
 	void _parseAnnotation() {
 		while (_isBound(0) && _get(0).kind == TokenKind::annotationKey) {
 			Pair annotation;
-			annotation.key = _eat().content;
+			annotation.key = _content(_eat());
 			if (_isBound(0) && _get(0).kind == TokenKind::annotationValue) {
-				annotation.value = _eat().content;
+				annotation.value = _content(_eat());
 			}
 			_annotations.push_back(annotation);
 		}
@@ -1474,6 +2024,10 @@ private:
 	}
 
 	Node* _parseAnnotatedBlock() {
+		if (!_enter()) {
+			return nullptr;
+		}
+
 		while (_get(0).kind == TokenKind::annotationKey) {
 			_parseAnnotation();
 
@@ -1487,7 +2041,7 @@ private:
 		if (node != nullptr) {
 			_firstNode = false;
 			if (_annotations.size() != 0) {
-				node->annotations = std::move(_annotations);
+				_takeAnnotations(node);
 			}
 		}
 
@@ -1495,6 +2049,8 @@ private:
 			_advance(1);
 		}
 
+		_depth -= 1;
+
 		return node;
 	}
 
@@ -1603,8 +2159,7 @@ private:
 	}
 
 	void _updateEndRange(Range& start, const Range& end) {
-		start.endLine = end.endLine;
-		start.endColumn = end.endColumn;
+		start.end = end.end;
 	}
 
 private:
@@ -1612,18 +2167,54 @@ private:
 
 	size_t _tokenIndex;
 
+	// the lexer window the line index of a streamed document was built over
+	std::string_view _window;
+
 	Document* _document;
 
+	IncludeCache* _includeCache;
+
+	// the cache of a parse with prefetched inclusions when no cache is given
+	IncludeCache _prefetchCache;
+
+	bool _prefetched;
+
 	std::string _workspaceFolder;
 
+	bool _workspaceFolderDeduced;
+
 	bool _fileInclusion;
 
 	bool _error;
 
 	bool _stopped;
 
+	std::vector<Diagnostic> _diagnostics;
+
+	DiagnosticHandler _diagnosticHandler;
+
 	bool _firstNode;
 
+	size_t _maximumDepth;
+
+	size_t _maximumInclusionDepth;
+
+	// how many files include this one, and their canonical paths, outermost first
+	size_t _inclusionDepth;
+
+	std::vector<std::string> _includers;
+
+	size_t _lexingThreadCount;
+
+	size_t _inclusionThreadCount;
+
+	size_t _depth;
+
+	// the open styles and quotes of the innermost _parseStyle and _parseIndent
+	std::vector<Style> _styles;
+
+	std::vector<Quote*> _quotes;
+
 	std::vector<Pair> _annotations;
 };
 
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Gularen {
+
+// Bump allocator, objects are carved out of large chunks and released all at once.
+// Objects that are not trivially destructible are destroyed on clear() without
+// freeing them one by one, the chunks go back to the system when the arena goes.
+// The chunks double in size up to maximumChunkSize, a small document stays in one.
+class Arena {
+public:
+	static constexpr size_t initialChunkSize = 4 * 1024;
+
+	static constexpr size_t maximumChunkSize = 1024 * 1024;
+
+	// a point to come back to, everything made after it is released by rewind()
+	struct Mark {
+		size_t chunk;
+		size_t offset;
+		void* destructors;
+	};
+
+	Arena() {
+		_chunkSize = initialChunkSize;
+		_chunk = 0;
+		_cursor = nullptr;
+		_end = nullptr;
+		_destructors = nullptr;
+	}
+
+	Arena(const Arena&) = delete;
+
+	Arena& operator=(const Arena&) = delete;
+
+	~Arena() {
+		clear();
+
+		for (const Chunk& chunk : _chunks) {
+			std::free(chunk.data);
+		}
+	}
+
+	template <typename T, typename... Arguments>
+	T* create(Arguments&&... arguments) {
+		void* memory = _allocate(sizeof(T), alignof(T));
+		T* object = new (memory) T(std::forward<Arguments>(arguments)...);
+
+		if constexpr (!std::is_trivially_destructible_v<T>) {
+			_pushDestructor(object, [](void* object) {
+				static_cast<T*>(object)->~T();
+			});
+		}
+
+		return object;
+	}
+
+	// Uninitialized room for count items, never destroyed.
+	template <typename T>
+	T* allocate(size_t count) {
+		static_assert(std::is_trivially_destructible_v<T>);
+
+		return static_cast<T*>(_allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// Deletes the object on clear(), for objects that were made with new elsewhere.
+	template <typename T>
+	T* adopt(T* object) {
+		_pushDestructor(object, [](void* object) {
+			delete static_cast<T*>(object);
+		});
+
+		return object;
+	}
+
+	Mark mark() const {
+		if (_cursor == nullptr) {
+			return { 0, 0, nullptr };
+		}
+
+		return { _chunk, static_cast<size_t>(_cursor - _chunks[_chunk].data), _destructors };
+	}
+
+	// Destroys every object made after the mark, the newest first.
+	// The chunks are kept, the next objects fill them again without asking the system.
+	void rewind(const Mark& mark) {
+		while (_destructors != mark.destructors) {
+			Destructor* destructor = _destructors;
+			_destructors = destructor->next;
+			destructor->destroy(destructor->object);
+		}
+
+		if (_chunks.empty()) {
+			return;
+		}
+
+		_chunk = mark.chunk;
+		_cursor = _chunks[_chunk].data + mark.offset;
+		_end = _chunks[_chunk].data + _chunks[_chunk].size;
+	}
+
+	void clear() {
+		rewind({ 0, 0, nullptr });
+	}
+
+	// bytes held from the system
+	size_t capacity() const {
+		size_t capacity = 0;
+
+		for (const Chunk& chunk : _chunks) {
+			capacity += chunk.size;
+		}
+
+		return capacity;
+	}
+
+private:
+	struct Chunk {
+		char* data;
+		size_t size;
+	};
+
+	struct Destructor {
+		Destructor* next;
+		void (*destroy)(void* object);
+		void* object;
+	};
+
+	void _pushDestructor(void* object, void (*destroy)(void* object)) {
+		Destructor* destructor = static_cast<Destructor*>(_allocate(sizeof(Destructor), alignof(Destructor)));
+		destructor->next = _destructors;
+		destructor->destroy = destroy;
+		destructor->object = object;
+		_destructors = destructor;
+	}
+
+	void* _allocate(size_t size, size_t alignment) {
+		char* memory = _align(_cursor, alignment);
+
+		if (_cursor == nullptr || memory + size > _end) {
+			_grow(size + alignment);
+			memory = _align(_cursor, alignment);
+		}
+
+		_cursor = memory + size;
+
+		return memory;
+	}
+
+	static char* _align(char* pointer, size_t alignment) {
+		size_t address = reinterpret_cast<size_t>(pointer);
+
+		return pointer + ((alignment - address % alignment) % alignment);
+	}
+
+	void _grow(size_t size) {
+		size_t next = _cursor == nullptr ? 0 : _chunk + 1;
+
+		// a chunk left over from before a rewind
+		if (next < _chunks.size() && _chunks[next].size >= size) {
+			_chunk = next;
+			_cursor = _chunks[next].data;
+			_end = _cursor + _chunks[next].size;
+			return;
+		}
+
+		size_t chunkSize = _chunkSize;
+
+		while (chunkSize < size) {
+			chunkSize *= 2;
+		}
+
+		char* data = static_cast<char*>(std::malloc(chunkSize));
+
+		if (data == nullptr) {
+			throw std::bad_alloc();
+		}
+
+		_chunks.insert(_chunks.begin() + next, { data, chunkSize });
+		_chunk = next;
+		_cursor = data;
+		_end = data + chunkSize;
+
+		if (_chunkSize < maximumChunkSize) {
+			_chunkSize *= 2;
+		}
+	}
+
+private:
+	// in the order they are filled
+	std::vector<Chunk> _chunks;
+
+	// the chunk the cursor is in
+	size_t _chunk;
+
+	// the size of the next chunk
+	size_t _chunkSize;
+
+	char* _cursor;
+
+	char* _end;
+
+	// newest first
+	Destructor* _destructors;
+};
+
+}
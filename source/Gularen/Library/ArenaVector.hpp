@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Gularen/Library/Arena.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Gularen {
+
+// Growable array whose items live in an arena, reads like a std::vector.
+// The arena to grow into is given on every write, so the vector itself is only
+// a pointer and two counts and owns nothing; a grown out array stays behind in
+// the arena until it is cleared. Only for items that may be copied as bytes.
+template <typename T>
+class ArenaVector {
+	static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+
+public:
+	static constexpr uint32_t initialCapacity = 2;
+
+	ArenaVector() {
+		_items = nullptr;
+		_size = 0;
+		_capacity = 0;
+	}
+
+	void push_back(const T& item, Arena& arena) {
+		if (_size == _capacity) {
+			_reallocate(_capacity == 0 ? initialCapacity : _capacity * 2, arena);
+		}
+
+		_items[_size] = item;
+		_size += 1;
+	}
+
+	void assign(const T* items, size_t size, Arena& arena) {
+		_size = 0;
+
+		if (size > _capacity) {
+			_reallocate(static_cast<uint32_t>(size), arena);
+		}
+
+		if (size != 0) {
+			std::memcpy(_items, items, sizeof(T) * size);
+		}
+
+		_size = static_cast<uint32_t>(size);
+	}
+
+	T* erase(T* position) {
+		std::memmove(position, position + 1, sizeof(T) * (end() - position - 1));
+		_size -= 1;
+
+		return position;
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+
+	T& operator[](size_t index) {
+		return _items[index];
+	}
+
+	const T& operator[](size_t index) const {
+		return _items[index];
+	}
+
+	T& front() {
+		return _items[0];
+	}
+
+	const T& front() const {
+		return _items[0];
+	}
+
+	T& back() {
+		return _items[_size - 1];
+	}
+
+	const T& back() const {
+		return _items[_size - 1];
+	}
+
+	T* begin() {
+		return _items;
+	}
+
+	const T* begin() const {
+		return _items;
+	}
+
+	T* end() {
+		return _items + _size;
+	}
+
+	const T* end() const {
+		return _items + _size;
+	}
+
+private:
+	void _reallocate(uint32_t capacity, Arena& arena) {
+		T* items = arena.allocate<T>(capacity);
+
+		if (_size != 0) {
+			std::memcpy(items, _items, sizeof(T) * _size);
+		}
+
+		_items = items;
+		_capacity = capacity;
+	}
+
+private:
+	T* _items;
+
+	uint32_t _size;
+
+	uint32_t _capacity;
+};
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Gularen {
+
+// Byte classification shared by the lexer and the composers.
+// Each byte maps to a set of flags, so a class test is a single table lookup.
+class CharClass {
+public:
+	static constexpr uint8_t alpha = 1 << 0;
+	static constexpr uint8_t digit = 1 << 1;
+	static constexpr uint8_t whitespace = 1 << 2;
+
+	// bytes that end a text run and are dispatched by Lexer::_parseInline
+	static constexpr uint8_t inlineDelimiter = 1 << 3;
+
+	// bytes that may open a block construct at the start of a line
+	static constexpr uint8_t blockStart = 1 << 4;
+
+	// @account and #hash tags
+	static constexpr uint8_t tagChar = 1 << 5;
+
+	// ~~ annotation-key = value
+	static constexpr uint8_t keyChar = 1 << 6;
+
+	// :emoji-code:
+	static constexpr uint8_t emojiChar = 1 << 7;
+
+	static constexpr uint8_t alphanumeric = alpha | digit;
+
+	static constexpr bool is(char c, uint8_t mask) {
+		return (_table[static_cast<unsigned char>(c)] & mask) != 0;
+	}
+
+	static constexpr bool isAlpha(char c) {
+		return is(c, alpha);
+	}
+
+	static constexpr bool isDigit(char c) {
+		return is(c, digit);
+	}
+
+	static constexpr bool isAlphanumeric(char c) {
+		return is(c, alphanumeric);
+	}
+
+private:
+	using Table = std::array<uint8_t, 256>;
+
+	static constexpr void _set(Table& table, const char* bytes, uint8_t flags) {
+		for (std::size_t i = 0; bytes[i] != '\0'; i += 1) {
+			table[static_cast<unsigned char>(bytes[i])] |= flags;
+		}
+	}
+
+	static constexpr Table _build() {
+		Table table = {};
+
+		for (int c = 'a'; c <= 'z'; c += 1) {
+			table[c] |= alpha | tagChar | keyChar | emojiChar;
+		}
+
+		for (int c = 'A'; c <= 'Z'; c += 1) {
+			table[c] |= alpha | tagChar | keyChar;
+		}
+
+		for (int c = '0'; c <= '9'; c += 1) {
+			table[c] |= digit | tagChar | keyChar | blockStart;
+		}
+
+		_set(table, " \t\n", whitespace);
+		_set(table, "*/_`~<|[:=-\"'\\\n@#!?^&+(", inlineDelimiter);
+		_set(table, ">/-(?|", blockStart);
+		_set(table, "_", tagChar);
+		_set(table, "-", keyChar | emojiChar);
+
+		return table;
+	}
+
+	static const Table _table;
+};
+
+// defined out of class, _build() can only run once CharClass is complete
+inline constexpr CharClass::Table CharClass::_table = CharClass::_build();
+
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define GULAREN_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Gularen {
+
+// Read-only content of a file.
+// A regular file is mapped into memory, so views into the content point straight
+// into the mapping and nothing is copied. Whatever cannot be mapped, a pipe, an
+// empty file or a platform without mmap, is read into a string instead.
+// The views stay valid until the buffer is closed or destroyed, a move takes them along.
+class FileBuffer {
+public:
+	FileBuffer() {
+		_data = nullptr;
+		_size = 0;
+		_mapped = false;
+	}
+
+	FileBuffer(const FileBuffer&) = delete;
+
+	FileBuffer& operator=(const FileBuffer&) = delete;
+
+	FileBuffer(FileBuffer&& other) {
+		_data = nullptr;
+		_size = 0;
+		_mapped = false;
+		*this = std::move(other);
+	}
+
+	FileBuffer& operator=(FileBuffer&& other) {
+		if (this == &other) {
+			return *this;
+		}
+
+		close();
+
+		_mapped = other._mapped;
+		_size = other._size;
+		_content = std::move(other._content);
+		_data = other._data;
+
+		other._data = nullptr;
+		other._size = 0;
+		other._mapped = false;
+		other._content.clear();
+
+		return *this;
+	}
+
+	~FileBuffer() {
+		close();
+	}
+
+	// Returns false when the file cannot be opened.
+	bool open(std::string_view path) {
+		close();
+
+		std::string pathString(path);
+
+		if (_map(pathString)) {
+			return true;
+		}
+
+		return _read(pathString);
+	}
+
+	void close() {
+		#ifdef GULAREN_MMAP
+		if (_mapped) {
+			munmap(const_cast<char*>(_data), _size);
+		}
+		#endif
+
+		_data = nullptr;
+		_size = 0;
+		_mapped = false;
+		_content.clear();
+	}
+
+	std::string_view view() const {
+		return std::string_view(_data, _size);
+	}
+
+	bool isMapped() const {
+		return _mapped;
+	}
+
+private:
+	bool _map(const std::string& path) {
+		#ifdef GULAREN_MMAP
+		int fd = ::open(path.c_str(), O_RDONLY);
+
+		if (fd < 0) {
+			return false;
+		}
+
+		struct stat status;
+
+		if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size == 0) {
+			::close(fd);
+			return false;
+		}
+
+		size_t size = static_cast<size_t>(status.st_size);
+		void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		// the mapping holds its own reference to the file
+		::close(fd);
+
+		if (data == MAP_FAILED) {
+			return false;
+		}
+
+		// the lexer reads front to back, let the kernel read ahead
+		madvise(data, size, MADV_SEQUENTIAL);
+
+		_data = static_cast<const char*>(data);
+		_size = size;
+		_mapped = true;
+
+		return true;
+		#else
+		(void) path;
+		return false;
+		#endif
+	}
+
+	bool _read(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+
+		if (!file.is_open()) {
+			return false;
+		}
+
+		// the size of a pipe is not known up front, read until it runs dry
+		char chunk[64 * 1024];
+
+		while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0) {
+			_content.insert(_content.end(), chunk, chunk + file.gcount());
+		}
+
+		_data = _content.data();
+		_size = _content.size();
+
+		return true;
+	}
+
+private:
+	const char* _data;
+
+	size_t _size;
+
+	bool _mapped;
+
+	// the fallback when the file is not mapped, unlike a string it keeps its bytes in place on a move
+	std::vector<char> _content;
+};
+
+}
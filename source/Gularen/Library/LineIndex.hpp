@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace Gularen {
+
+struct Position {
+	size_t line;
+	size_t column;
+};
+
+// Maps byte offsets to zero-based line and column.
+// The line starts are collected on the first lookup, so content that is never
+// asked for a position costs nothing. Lookups are a binary search over them.
+// The first lookup mutates the index, do not share one between threads before that.
+// The content may be a window of a larger input that starts at the given offset and
+// line, a streaming parser only holds that much of it.
+class LineIndex {
+public:
+	LineIndex() {
+		_offset = 0;
+		_line = 0;
+	}
+
+	LineIndex(std::string_view content, size_t offset = 0, size_t line = 0): _content(content) {
+		_offset = offset;
+		_line = line;
+	}
+
+	void assign(std::string_view content, size_t offset = 0, size_t line = 0) {
+		_content = content;
+		_offset = offset;
+		_line = line;
+		_lineStarts.clear();
+	}
+
+	// offset is in the whole input and must lie within the window
+	Position position(size_t offset) const {
+		_build();
+
+		offset -= _offset;
+
+		// the last line start that is not past the offset
+		size_t line = std::upper_bound(_lineStarts.begin(), _lineStarts.end(), offset) - _lineStarts.begin() - 1;
+
+		return Position { _line + line, offset - _lineStarts[line] };
+	}
+
+	size_t lineCount() const {
+		_build();
+
+		return _lineStarts.size();
+	}
+
+private:
+	void _build() const {
+		if (!_lineStarts.empty()) {
+			return;
+		}
+
+		_lineStarts.push_back(0);
+
+		const char* begin = _content.data();
+		const char* end = begin + _content.size();
+		const char* lineStart = begin;
+
+		// memchr is vectorized by the C library, it beats a byte loop by a wide margin
+		while (lineStart < end) {
+			const char* newline = static_cast<const char*>(std::memchr(lineStart, '\n', end - lineStart));
+
+			if (newline == nullptr) {
+				break;
+			}
+
+			lineStart = newline + 1;
+			_lineStarts.push_back(static_cast<uint32_t>(lineStart - begin));
+		}
+	}
+
+private:
+	std::string_view _content;
+
+	size_t _offset;
+
+	size_t _line;
+
+	mutable std::vector<uint32_t> _lineStarts;
+};
+
+}
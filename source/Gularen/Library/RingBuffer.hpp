@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Gularen {
+
+// First-in first-out window over a growing sequence.
+// The capacity is a power of two and doubles when the buffer is full,
+// so a buffer that is never popped behaves like a vector.
+template <typename T>
+class RingBuffer {
+public:
+	RingBuffer() {
+		_front = 0;
+		_size = 0;
+	}
+
+	void clear() {
+		_front = 0;
+		_size = 0;
+	}
+
+	inline size_t size() const {
+		return _size;
+	}
+
+	inline bool empty() const {
+		return _size == 0;
+	}
+
+	T& operator[](size_t index) {
+		return _items[(_front + index) & (_items.size() - 1)];
+	}
+
+	const T& operator[](size_t index) const {
+		return _items[(_front + index) & (_items.size() - 1)];
+	}
+
+	// Makes room for at least capacity items without another growth.
+	void reserve(size_t capacity) {
+		size_t size = _items.empty() ? 64 : _items.size();
+
+		while (size < capacity) {
+			size *= 2;
+		}
+
+		if (size != _items.size()) {
+			_resize(size);
+		}
+	}
+
+	// Grows or shrinks to size items, new items are default constructed.
+	void resize(size_t size) {
+		reserve(size);
+
+		for (size_t i = _size; i < size; i += 1) {
+			(*this)[i] = T();
+		}
+
+		_size = size;
+	}
+
+	T& back() {
+		return (*this)[_size - 1];
+	}
+
+	void pushBack(const T& item) {
+		if (_size == _items.size()) {
+			_grow();
+		}
+
+		_items[(_front + _size) & (_items.size() - 1)] = item;
+		_size += 1;
+	}
+
+	void popBack(size_t count) {
+		if (count > _size) {
+			count = _size;
+		}
+
+		_size -= count;
+	}
+
+	void popFront(size_t count) {
+		if (count > _size) {
+			count = _size;
+		}
+
+		_front = (_front + count) & (_items.size() - 1);
+		_size -= count;
+	}
+
+	// Replaces count items at index with the given items, the items behind them move.
+	void splice(size_t index, size_t count, const RingBuffer& items) {
+		size_t tailSize = _size - index - count;
+		size_t size = _size - count + items.size();
+
+		while (_items.size() < size) {
+			_grow();
+		}
+
+		if (items.size() > count) {
+			for (size_t i = tailSize; i > 0; i -= 1) {
+				(*this)[index + items.size() + i - 1] = (*this)[index + count + i - 1];
+			}
+		} else {
+			for (size_t i = 0; i < tailSize; i += 1) {
+				(*this)[index + items.size() + i] = (*this)[index + count + i];
+			}
+		}
+
+		for (size_t i = 0; i < items.size(); i += 1) {
+			(*this)[index + i] = items[i];
+		}
+
+		_size = size;
+	}
+
+private:
+	void _grow() {
+		_resize(_items.empty() ? 64 : _items.size() * 2);
+	}
+
+	void _resize(size_t capacity) {
+		std::vector<T> items(capacity);
+
+		for (size_t i = 0; i < _size; i += 1) {
+			items[i] = (*this)[i];
+		}
+
+		_items.swap(items);
+		_front = 0;
+	}
+
+private:
+	std::vector<T> _items;
+
+	size_t _front;
+
+	size_t _size;
+};
+
+}
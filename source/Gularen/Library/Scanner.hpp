@@ -0,0 +1,186 @@
+#pragma once
+
+#include "Gularen/Library/CharClass.hpp"
+#include <cstddef>
+#include <string_view>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define GULAREN_SCANNER_SSE2
+#include <immintrin.h>
+#endif
+
+#if defined(GULAREN_SCANNER_SSE2) && (defined(__x86_64__) || defined(__i386__))
+#define GULAREN_SCANNER_AVX2
+#endif
+
+namespace Gularen {
+
+// Skips runs of text that cannot contain an inline delimiter.
+// The vector kernels only skip plain text: ASCII letters and digits, space, comma,
+// period and any byte of a multi-byte UTF-8 sequence, so they may stop early at a
+// byte that turns out not to be a delimiter. The lexer looks at those one by one.
+class Scanner {
+public:
+	enum class Kernel {
+		scalar,
+		sse2,
+		avx2,
+	};
+
+	// Returns an index at or after index and at or before the next inline delimiter.
+	static size_t skipPlain(std::string_view content, size_t index) {
+		return _function()(content.data(), content.size(), index);
+	}
+
+	static bool isSupported(Kernel kernel) {
+		switch (kernel) {
+			case Kernel::scalar:
+				return true;
+
+			case Kernel::sse2:
+				#ifdef GULAREN_SCANNER_SSE2
+				return true;
+				#else
+				return false;
+				#endif
+
+			case Kernel::avx2:
+				#ifdef GULAREN_SCANNER_AVX2
+				return __builtin_cpu_supports("avx2");
+				#else
+				return false;
+				#endif
+		}
+
+		return false;
+	}
+
+	// The widest supported kernel is picked on first use, this is only meant for benchmarks and tests.
+	static void setKernel(Kernel kernel) {
+		if (isSupported(kernel)) {
+			_kernel() = kernel;
+			_function() = _select(kernel);
+		}
+	}
+
+	static Kernel kernel() {
+		_function();
+		return _kernel();
+	}
+
+private:
+	using Function = size_t (*)(const char* data, size_t size, size_t index);
+
+	static Kernel& _kernel() {
+		static Kernel kernel = isSupported(Kernel::avx2) ? Kernel::avx2 : isSupported(Kernel::sse2) ? Kernel::sse2 : Kernel::scalar;
+		return kernel;
+	}
+
+	static Function& _function() {
+		static Function function = _select(_kernel());
+		return function;
+	}
+
+	static Function _select(Kernel kernel) {
+		switch (kernel) {
+			#ifdef GULAREN_SCANNER_AVX2
+			case Kernel::avx2: return _skipPlainAvx2;
+			#endif
+
+			#ifdef GULAREN_SCANNER_SSE2
+			case Kernel::sse2: return _skipPlainSse2;
+			#endif
+
+			default: return _skipPlainScalar;
+		}
+	}
+
+	static size_t _skipPlainScalar(const char* data, size_t size, size_t index) {
+		while (index < size && !CharClass::is(data[index], CharClass::inlineDelimiter)) {
+			index += 1;
+		}
+
+		return index;
+	}
+
+	#ifdef GULAREN_SCANNER_SSE2
+	static size_t _skipPlainSse2(const char* data, size_t size, size_t index) {
+		const __m128i caseBit = _mm_set1_epi8(0x20);
+		const __m128i letterFirst = _mm_set1_epi8('a');
+		const __m128i letterSpan = _mm_set1_epi8('z' - 'a');
+		const __m128i digitFirst = _mm_set1_epi8('0');
+		const __m128i digitSpan = _mm_set1_epi8('9' - '0');
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i comma = _mm_set1_epi8(',');
+		const __m128i period = _mm_set1_epi8('.');
+
+		while (index + 16 <= size) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+
+			// (c | 0x20) - 'a' <= 25 and c - '0' <= 9, as unsigned range checks
+			__m128i letter = _mm_sub_epi8(_mm_or_si128(chunk, caseBit), letterFirst);
+			letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, letterSpan), letter);
+
+			__m128i digit = _mm_sub_epi8(chunk, digitFirst);
+			digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, digitSpan), digit);
+
+			__m128i plain = _mm_or_si128(
+				_mm_or_si128(letter, digit),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_or_si128(_mm_cmpeq_epi8(chunk, comma), _mm_cmpeq_epi8(chunk, period)))
+			);
+
+			// the sign bit marks UTF-8 bytes, which are plain as well
+			unsigned int mask = ~static_cast<unsigned int>(_mm_movemask_epi8(plain) | _mm_movemask_epi8(chunk)) & 0xFFFF;
+
+			if (mask != 0) {
+				return index + __builtin_ctz(mask);
+			}
+
+			index += 16;
+		}
+
+		return _skipPlainScalar(data, size, index);
+	}
+	#endif
+
+	#ifdef GULAREN_SCANNER_AVX2
+	__attribute__((target("avx2")))
+	static size_t _skipPlainAvx2(const char* data, size_t size, size_t index) {
+		const __m256i caseBit = _mm256_set1_epi8(0x20);
+		const __m256i letterFirst = _mm256_set1_epi8('a');
+		const __m256i letterSpan = _mm256_set1_epi8('z' - 'a');
+		const __m256i digitFirst = _mm256_set1_epi8('0');
+		const __m256i digitSpan = _mm256_set1_epi8('9' - '0');
+		const __m256i space = _mm256_set1_epi8(' ');
+		const __m256i comma = _mm256_set1_epi8(',');
+		const __m256i period = _mm256_set1_epi8('.');
+
+		while (index + 32 <= size) {
+			__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+
+			__m256i letter = _mm256_sub_epi8(_mm256_or_si256(chunk, caseBit), letterFirst);
+			letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, letterSpan), letter);
+
+			__m256i digit = _mm256_sub_epi8(chunk, digitFirst);
+			digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, digitSpan), digit);
+
+			__m256i plain = _mm256_or_si256(
+				_mm256_or_si256(letter, digit),
+				_mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_or_si256(_mm256_cmpeq_epi8(chunk, comma), _mm256_cmpeq_epi8(chunk, period)))
+			);
+
+			unsigned int mask = ~static_cast<unsigned int>(_mm256_movemask_epi8(plain) | _mm256_movemask_epi8(chunk));
+
+			if (mask != 0) {
+				return index + __builtin_ctz(mask);
+			}
+
+			index += 32;
+		}
+
+		return _skipPlainSse2(data, size, index);
+	}
+	#endif
+};
+
+}
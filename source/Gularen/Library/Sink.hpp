@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define GULAREN_WRITEV
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace Gularen {
+
+// Where composed output goes.
+// Appending copies into a buffer and only a buffer that runs out of room is handed
+// to the sink, so the sink decides how much of the output is held at once.
+// Whatever is still buffered is handed on by flush(), the sinks that write somewhere
+// also flush when they are destroyed.
+class Sink {
+public:
+	Sink() {
+		_begin = nullptr;
+		_cursor = nullptr;
+		_end = nullptr;
+		_good = true;
+	}
+
+	Sink(const Sink&) = delete;
+
+	Sink& operator=(const Sink&) = delete;
+
+	virtual ~Sink() {
+	}
+
+	void append(std::string_view content) {
+		append(content.data(), content.size());
+	}
+
+	// an empty view may have no data, memcpy() is not handed it
+	void append(const char* data, size_t size) {
+		if (size == 0) {
+			return;
+		}
+
+		if (size <= static_cast<size_t>(_end - _cursor)) {
+			std::memcpy(_cursor, data, size);
+			_cursor += size;
+			return;
+		}
+
+		_overflow(data, size);
+	}
+
+	void append(size_t count, char byte) {
+		while (count != 0) {
+			push_back(byte);
+			count -= 1;
+		}
+	}
+
+	void push_back(char byte) {
+		if (_cursor == _end) {
+			_overflow(&byte, 1);
+			return;
+		}
+
+		*_cursor = byte;
+		_cursor += 1;
+	}
+
+	virtual void flush() {
+	}
+
+	// False once something could not be written, the output after that is dropped.
+	bool good() const {
+		return _good;
+	}
+
+protected:
+	// Takes the bytes that do not fit into the room left in the buffer, all of them.
+	virtual void _overflow(const char* data, size_t size) = 0;
+
+protected:
+	char* _begin;
+
+	char* _cursor;
+
+	char* _end;
+
+	bool _good;
+};
+
+// Keeps the whole output in memory, the buffer grows to fit.
+// Clearing keeps what was allocated, so a sink that is reused stops allocating.
+// Reserving the size the output is expected to have up front saves the growing.
+class StringSink : public Sink {
+public:
+	StringSink() {
+		_capacity = 0;
+		_growthCount = 0;
+		_grow(256);
+	}
+
+	std::string_view view() const {
+		return std::string_view(_begin, _cursor - _begin);
+	}
+
+	size_t size() const {
+		return _cursor - _begin;
+	}
+
+	size_t capacity() const {
+		return _capacity;
+	}
+
+	// How often the buffer had to grow since the last clear(), reserving does not count.
+	size_t growthCount() const {
+		return _growthCount;
+	}
+
+	void reserve(size_t capacity) {
+		if (capacity > _capacity) {
+			_grow(capacity);
+		}
+	}
+
+	void clear() {
+		_cursor = _begin;
+		_growthCount = 0;
+	}
+
+protected:
+	void _overflow(const char* data, size_t size) override {
+		if (size == 0) {
+			return;
+		}
+
+		_grow(std::max(_capacity * 2, this->size() + size));
+		_growthCount += 1;
+		std::memcpy(_cursor, data, size);
+		_cursor += size;
+	}
+
+private:
+	// unlike a string the new buffer is not filled with zeros first
+	void _grow(size_t capacity) {
+		size_t size = this->size();
+		std::unique_ptr<char[]> content(new char[capacity]);
+
+		if (size != 0) {
+			std::memcpy(content.get(), _begin, size);
+		}
+
+		_content = std::move(content);
+		_capacity = capacity;
+		_begin = _content.get();
+		_cursor = _begin + size;
+		_end = _begin + capacity;
+	}
+
+private:
+	std::unique_ptr<char[]> _content;
+
+	size_t _capacity;
+
+	size_t _growthCount;
+};
+
+// Writes to a file descriptor through a buffer of a fixed size.
+// Content larger than the buffer is written along with the buffered bytes in one
+// writev() instead of being copied through the buffer. The descriptor is not closed.
+class FileSink : public Sink {
+public:
+	FileSink(int descriptor, size_t capacity = 64 * 1024) {
+		_descriptor = descriptor;
+		_buffer.resize(capacity == 0 ? 1 : capacity);
+		_begin = _buffer.data();
+		_cursor = _begin;
+		_end = _begin + _buffer.size();
+	}
+
+	~FileSink() {
+		flush();
+	}
+
+	void flush() override {
+		_write(_begin, _cursor - _begin, nullptr, 0);
+		_cursor = _begin;
+	}
+
+protected:
+	void _overflow(const char* data, size_t size) override {
+		if (size == 0) {
+			return;
+		}
+
+		if (size < _buffer.size() / 2) {
+			flush();
+			std::memcpy(_cursor, data, size);
+			_cursor += size;
+			return;
+		}
+
+		_write(_begin, _cursor - _begin, data, size);
+		_cursor = _begin;
+	}
+
+private:
+	void _write(const char* first, size_t firstSize, const char* second, size_t secondSize) {
+		#ifdef GULAREN_WRITEV
+		struct iovec parts[2];
+		parts[0].iov_base = const_cast<char*>(first);
+		parts[0].iov_len = firstSize;
+		parts[1].iov_base = const_cast<char*>(second);
+		parts[1].iov_len = secondSize;
+
+		struct iovec* part = parts;
+		int partCount = 2;
+
+		while (_good && partCount != 0) {
+			if (part->iov_len == 0) {
+				part += 1;
+				partCount -= 1;
+				continue;
+			}
+
+			ssize_t written = writev(_descriptor, part, partCount);
+
+			if (written < 0) {
+				if (errno != EINTR) {
+					_good = false;
+				}
+
+				continue;
+			}
+
+			// a short write leaves the rest of the parts for the next round
+			size_t left = static_cast<size_t>(written);
+
+			while (partCount != 0 && left >= part->iov_len) {
+				left -= part->iov_len;
+				part += 1;
+				partCount -= 1;
+			}
+
+			if (partCount != 0) {
+				part->iov_base = static_cast<char*>(part->iov_base) + left;
+				part->iov_len -= left;
+			}
+		}
+		#else
+		(void) first;
+		(void) second;
+
+		if (firstSize != 0 || secondSize != 0) {
+			_good = false;
+		}
+		#endif
+	}
+
+private:
+	int _descriptor;
+
+	std::vector<char> _buffer;
+};
+
+// Writes to a stream through a buffer of a fixed size, for output that is not a file descriptor.
+class StreamSink : public Sink {
+public:
+	StreamSink(std::ostream& stream, size_t capacity = 64 * 1024): _stream(stream) {
+		_buffer.resize(capacity == 0 ? 1 : capacity);
+		_begin = _buffer.data();
+		_cursor = _begin;
+		_end = _begin + _buffer.size();
+	}
+
+	~StreamSink() {
+		flush();
+	}
+
+	void flush() override {
+		_write(_begin, _cursor - _begin);
+		_cursor = _begin;
+		_stream.flush();
+	}
+
+protected:
+	void _overflow(const char* data, size_t size) override {
+		if (size == 0) {
+			return;
+		}
+
+		_write(_begin, _cursor - _begin);
+		_cursor = _begin;
+
+		if (size < _buffer.size() / 2) {
+			std::memcpy(_cursor, data, size);
+			_cursor += size;
+			return;
+		}
+
+		_write(data, size);
+	}
+
+private:
+	void _write(const char* data, size_t size) {
+		if (size == 0 || !_good) {
+			return;
+		}
+
+		_stream.write(data, size);
+		_good = static_cast<bool>(_stream);
+	}
+
+private:
+	std::ostream& _stream;
+
+	std::vector<char> _buffer;
+};
+
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Gularen {
+
+// Runs tasks on a pool of worker threads that is started on first use and kept for the
+// rest of the process, so a run does not pay for starting threads. The pool grows to the
+// most threads a run has asked for. The calling thread works on its own run as well, a run
+// inside a task therefore always makes progress even when every worker is busy.
+class Tasks {
+public:
+	// Runs task(0) to task(count - 1) on up to threadCount threads, this one included.
+	// The tasks are handed out in order, a thread takes the next one when it is done.
+	template <typename Task>
+	static void run(size_t count, size_t threadCount, const Task& task) {
+		#ifdef __EMSCRIPTEN__
+		(void) threadCount;
+
+		for (size_t i = 0; i < count; i += 1) {
+			task(i);
+		}
+		#else
+		size_t helperCount = std::min(threadCount, count);
+		helperCount = helperCount == 0 ? 0 : helperCount - 1;
+
+		if (helperCount == 0) {
+			for (size_t i = 0; i < count; i += 1) {
+				task(i);
+			}
+
+			return;
+		}
+
+		Job job;
+		job.next = 0;
+		job.count = count;
+		job.context = &task;
+		job.function = [](const void* context, size_t index) {
+			(*static_cast<const Task*>(context))(index);
+		};
+
+		_pool().run(job, helperCount);
+		#endif
+	}
+
+private:
+	struct Job {
+		std::atomic<size_t> next;
+
+		size_t count;
+
+		const void* context;
+
+		void (*function)(const void* context, size_t index);
+
+		// how many more workers may join, under the lock of the pool
+		size_t slotCount;
+
+		// how many workers are on it, under the lock of the pool
+		size_t helperCount;
+
+		void work() {
+			for (size_t i = next++; i < count; i = next++) {
+				function(context, i);
+			}
+		}
+	};
+
+	class Pool {
+	public:
+		Pool() {
+			_stopping = false;
+		}
+
+		~Pool() {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stopping = true;
+			}
+
+			_wake.notify_all();
+
+			for (std::thread& thread : _threads) {
+				thread.join();
+			}
+		}
+
+		void run(Job& job, size_t helperCount) {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				while (_threads.size() < helperCount) {
+					_threads.emplace_back([this]() {
+						_serve();
+					});
+				}
+
+				job.slotCount = helperCount;
+				job.helperCount = 0;
+				_jobs.push_back(&job);
+			}
+
+			_wake.notify_all();
+			job.work();
+
+			// the workers that did not get to the job are not waited for
+			std::unique_lock<std::mutex> lock(_mutex);
+			_jobs.erase(std::remove(_jobs.begin(), _jobs.end(), &job), _jobs.end());
+			_done.wait(lock, [&job]() {
+				return job.helperCount == 0;
+			});
+		}
+
+	private:
+		void _serve() {
+			std::unique_lock<std::mutex> lock(_mutex);
+
+			while (true) {
+				_wake.wait(lock, [this]() {
+					return _stopping || !_jobs.empty();
+				});
+
+				if (_stopping) {
+					return;
+				}
+
+				Job* job = _jobs.front();
+				job->slotCount -= 1;
+				job->helperCount += 1;
+
+				if (job->slotCount == 0) {
+					_jobs.pop_front();
+				}
+
+				lock.unlock();
+				job->work();
+				lock.lock();
+
+				job->helperCount -= 1;
+
+				if (job->helperCount == 0) {
+					_done.notify_all();
+				}
+			}
+		}
+
+	private:
+		std::mutex _mutex;
+
+		std::condition_variable _wake;
+
+		std::condition_variable _done;
+
+		std::deque<Job*> _jobs;
+
+		std::vector<std::thread> _threads;
+
+		bool _stopping;
+	};
+
+	static Pool& _pool() {
+		static Pool pool;
+		return pool;
+	}
+};
+
+}
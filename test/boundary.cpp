@@ -0,0 +1,69 @@
+#include "Gularen/Frontend/Parser.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+using namespace Gularen;
+
+// A mapped file has nothing after its last byte, a file of a whole page that ends in the middle
+// of a lookahead must not be read past. Built with _GLIBCXX_ASSERTIONS every read past the
+// content aborts, not just one that reaches an unmapped page.
+static bool check(const std::filesystem::path& path, std::string_view name, const std::string& content) {
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << content;
+	}
+
+	Parser parser;
+	parser.setFileInclusion(false);
+	bool pass = parser.parseFile(path.string()) != nullptr;
+
+	std::cout << (pass ? "PASS " : "FAIL ") << "boundary/" << name << " (" << content.size() << " bytes)\n";
+
+	return pass;
+}
+
+// Content past the 32-bit token offsets is turned down before it is lexed. The file is sparse,
+// it takes no space and the parser never reads it.
+static bool checkSize(const std::filesystem::path& path) {
+	{
+		std::ofstream file(path, std::ios::binary);
+	}
+
+	std::filesystem::resize_file(path, Lexer::maximumContentSize + 1);
+
+	Parser parser;
+	parser.setFileInclusion(false);
+	Document* document = parser.parseFile(path.string());
+	const std::vector<Diagnostic>& diagnostics = parser.diagnostics();
+
+	bool pass = document != nullptr && document->children.empty();
+	pass = pass && diagnostics.size() == 1 && diagnostics[0].code == Diagnostic::Code::tooLarge;
+
+	std::cout << (pass ? "PASS " : "FAIL ") << "boundary/size\n";
+
+	return pass;
+}
+
+int main() {
+	size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "gularen-test-boundary.gr";
+	bool pass = true;
+
+	// every byte the lexer may look past, last in the file
+	for (char last : std::string_view("=+-)(!*<>&[]:~.#@/ 0123456789x")) {
+		std::string content(pageSize - 1, 'x');
+		content.push_back(last);
+		pass = check(path, std::string("last/") + last, content) && pass;
+	}
+
+	// a code block that is never closed looks for its closing dashes to the end
+	std::string code = "---\n" + std::string(pageSize - 5, 'x') + "\n";
+	pass = check(path, "code", code) && pass;
+	pass = checkSize(path) && pass;
+
+	std::filesystem::remove(path);
+
+	return pass ? 0 : 1;
+}
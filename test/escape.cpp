@@ -0,0 +1,265 @@
+#include "Gularen/Backend/Html/Escaper.hpp"
+#include "Gularen/Backend/Json/Escaper.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <utility>
+
+using namespace Gularen;
+
+// the escaping one byte at a time that every kernel has to match
+static std::string escapeHtml(std::string_view content, bool attribute) {
+	std::string escaped;
+
+	for (size_t i = 0; i < content.size(); i += 1) {
+		switch (content[i]) {
+			case '<': escaped.append(attribute ? "<" : "&lt;"); break;
+			case '>': escaped.append(attribute ? ">" : "&gt;"); break;
+			case '&': escaped.append(attribute ? "&" : "&amp;"); break;
+			case '\"': escaped.append("&quot;"); break;
+			case '\'': escaped.append("&#39;"); break;
+			default: escaped.append(1, content[i]); break;
+		}
+	}
+
+	return escaped;
+}
+
+// the length of the UTF-8 sequence at index going by the code point it decodes to, 0 when it is not well-formed
+static size_t utf8Length(std::string_view content, size_t index) {
+	unsigned char byte = content[index];
+	size_t length = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 0;
+
+	if (length == 0 || byte >= 0xF8 || index + length > content.size()) {
+		return 0;
+	}
+
+	uint32_t codepoint = byte & (0x7F >> length);
+
+	for (size_t i = 1; i < length; i += 1) {
+		unsigned char next = content[index + i];
+
+		if ((next & 0xC0) != 0x80) {
+			return 0;
+		}
+
+		codepoint = (codepoint << 6) | (next & 0x3F);
+	}
+
+	uint32_t minimum = length == 2 ? 0x80 : length == 3 ? 0x800 : 0x10000;
+
+	if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+		return 0;
+	}
+
+	return length;
+}
+
+// the JSON escaping one byte at a time that every kernel has to match
+static std::string escapeJson(std::string_view content) {
+	std::string escaped;
+	size_t i = 0;
+
+	while (i < content.size()) {
+		unsigned char byte = content[i];
+
+		if (byte >= 0x80) {
+			size_t length = utf8Length(content, i);
+
+			if (length == 0) {
+				escaped.append("\\uFFFD");
+				i += 1;
+			} else {
+				escaped.append(content.substr(i, length));
+				i += length;
+			}
+
+			continue;
+		}
+
+		switch (byte) {
+			case '"': escaped.append("\\\""); break;
+			case '\\': escaped.append("\\\\"); break;
+			case '/': escaped.append("\\/"); break;
+			case 8: escaped.append("\\b"); break;
+			case 12: escaped.append("\\f"); break;
+			case '\r': escaped.append("\\r"); break;
+			case '\n': escaped.append("\\n"); break;
+			case '\t': escaped.append("\\t"); break;
+			default: {
+				if (byte >= ' ' && byte <= '~') {
+					escaped.push_back(byte);
+				} else {
+					char code[8];
+					std::snprintf(code, sizeof(code), "\\u%04X", byte);
+					escaped.append(code);
+				}
+				break;
+			}
+		}
+
+		i += 1;
+	}
+
+	return escaped;
+}
+
+// Random strings of every length around the chunk sizes, dense and sparse in bytes
+// to escape, strings of well-formed and broken UTF-8, then the published specification.
+static std::vector<std::string> collectSamples() {
+	std::vector<std::string> samples;
+	std::mt19937 random(7);
+	std::string_view alphabet = "ab <>&\"'\\/\n\t\b\f\r\x01\x1f\x7f\xc3\xa9\xe2\x80\x94\xf0\x9f\x98\x80";
+
+	// well-formed and broken UTF-8: overlong, surrogate, past U+10FFFF, cut short and stray bytes
+	std::string_view sequences[] = {
+		"\xc3\xa9", "\xe2\x80\x94", "\xf0\x9f\x98\x80", "\xf4\x8f\xbf\xbf", "\xef\xbf\xbd",
+		"\xc0\xaf", "\xc1\xbf", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80",
+		"\xe2\x80", "\xf0\x9f\x98", "\x80", "\xbf", "\xfe", "\xff",
+	};
+
+	for (size_t size = 0; size < 140; size += 1) {
+		for (size_t density = 1; density <= 64; density *= 4) {
+			std::string sample;
+
+			for (size_t i = 0; i < size; i += 1) {
+				sample.push_back(random() % density == 0 ? alphabet[random() % alphabet.size()] : 'x');
+			}
+
+			samples.push_back(sample);
+		}
+	}
+
+	for (size_t size = 0; size < 80; size += 1) {
+		std::string sample;
+
+		while (sample.size() < size) {
+			sample.append(random() % 3 == 0 ? "x" : sequences[random() % std::size(sequences)]);
+		}
+
+		samples.push_back(sample);
+	}
+
+	for (const auto& entry : std::filesystem::directory_iterator("resource/spec/published")) {
+		std::ifstream file(entry.path());
+		samples.push_back(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+	}
+
+	return samples;
+}
+
+static bool checkHtml(std::string_view name, Html::Escaper::Kernel kernel, const std::vector<std::string>& samples) {
+	if (!Html::Escaper::isSupported(kernel)) {
+		std::cout << "SKIP escape/html/" << name << " (unsupported)\n";
+		return true;
+	}
+
+	Html::Escaper::setKernel(kernel);
+
+	StringSink sink;
+	size_t failures = 0;
+
+	for (const std::string& sample : samples) {
+		for (bool attribute : { false, true }) {
+			sink.clear();
+
+			if (attribute) {
+				Html::Escaper::escapeAttribute(sample, sink);
+			} else {
+				Html::Escaper::escape(sample, sink);
+			}
+
+			if (sink.view() != escapeHtml(sample, attribute)) {
+				failures += 1;
+			}
+		}
+	}
+
+	std::cout << (failures == 0 ? "PASS " : "FAIL ") << "escape/html/" << name;
+	std::cout << " (" << samples.size() << " samples, " << failures << " mismatches)\n";
+
+	return failures == 0;
+}
+
+static bool checkJson(std::string_view name, Json::Escaper::Kernel kernel, const std::vector<std::string>& samples) {
+	if (!Json::Escaper::isSupported(kernel)) {
+		std::cout << "SKIP escape/json/" << name << " (unsupported)\n";
+		return true;
+	}
+
+	Json::Escaper::setKernel(kernel);
+
+	StringSink sink;
+	size_t failures = 0;
+
+	for (const std::string& sample : samples) {
+		sink.clear();
+		Json::Escaper::escape(sample, sink);
+
+		if (sink.view() != escapeJson(sample)) {
+			failures += 1;
+		}
+	}
+
+	std::cout << (failures == 0 ? "PASS " : "FAIL ") << "escape/json/" << name;
+	std::cout << " (" << samples.size() << " samples, " << failures << " mismatches)\n";
+
+	return failures == 0;
+}
+
+// Broken UTF-8 written out in full, one replacement character a byte, past the first chunk as well.
+static bool checkJsonInvalid(std::string_view name, Json::Escaper::Kernel kernel) {
+	if (!Json::Escaper::isSupported(kernel)) {
+		std::cout << "SKIP escape/json/invalid/" << name << " (unsupported)\n";
+		return true;
+	}
+
+	Json::Escaper::setKernel(kernel);
+
+	std::string padding(40, 'x');
+	std::pair<std::string, std::string> cases[] = {
+		{ "\xff", "\\uFFFD" },
+		{ "a\xc3(", "a\\uFFFD(" },
+		{ "\xe2\x80", "\\uFFFD\\uFFFD" },
+		{ "\xed\xa0\x80", "\\uFFFD\\uFFFD\\uFFFD" },
+		{ "\xc3\xa9\x80", "\xc3\xa9\\uFFFD" },
+		{ "\x01\x7f", "\\u0001\\u007F" },
+		{ padding + "\xc0\xaf" + padding, padding + "\\uFFFD\\uFFFD" + padding },
+	};
+
+	StringSink sink;
+	size_t failures = 0;
+
+	for (const auto& [content, expected] : cases) {
+		sink.clear();
+		Json::Escaper::escape(content, sink);
+
+		if (sink.view() != expected) {
+			failures += 1;
+		}
+	}
+
+	std::cout << (failures == 0 ? "PASS " : "FAIL ") << "escape/json/invalid/" << name;
+	std::cout << " (" << std::size(cases) << " cases, " << failures << " mismatches)\n";
+
+	return failures == 0;
+}
+
+int main() {
+	std::vector<std::string> samples = collectSamples();
+
+	bool pass = checkHtml("scalar", Html::Escaper::Kernel::scalar, samples);
+	pass = checkHtml("sse2", Html::Escaper::Kernel::sse2, samples) && pass;
+	pass = checkHtml("avx2", Html::Escaper::Kernel::avx2, samples) && pass;
+	pass = checkJson("scalar", Json::Escaper::Kernel::scalar, samples) && pass;
+	pass = checkJson("sse2", Json::Escaper::Kernel::sse2, samples) && pass;
+	pass = checkJson("avx2", Json::Escaper::Kernel::avx2, samples) && pass;
+	pass = checkJsonInvalid("scalar", Json::Escaper::Kernel::scalar) && pass;
+	pass = checkJsonInvalid("sse2", Json::Escaper::Kernel::sse2) && pass;
+	pass = checkJsonInvalid("avx2", Json::Escaper::Kernel::avx2) && pass;
+
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include "Gularen/Frontend/Parser.hpp"
+#include "Gularen/Frontend/NodeWalker.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace Gularen;
+
+static std::filesystem::path folder;
+
+static void write(std::string_view name, std::string_view content) {
+	std::ofstream file(folder / name);
+	file << content;
+}
+
+// the diagnostic codes of a parse of the file with the cache
+static std::vector<Diagnostic::Code> parse(IncludeCache& cache, std::string_view name, size_t maximumInclusionDepth) {
+	Parser parser;
+	parser.setIncludeCache(&cache);
+	parser.setMaximumInclusionDepth(maximumInclusionDepth);
+	parser.parseFile((folder / name).string());
+
+	std::vector<Diagnostic::Code> codes;
+
+	for (const Diagnostic& diagnostic : parser.diagnostics()) {
+		codes.push_back(diagnostic.code);
+	}
+
+	return codes;
+}
+
+// the text of every included file in document order
+static std::string textOf(IncludeCache& cache, std::string_view name) {
+	Parser parser;
+	parser.setIncludeCache(&cache);
+	Document* document = parser.parseFile((folder / name).string());
+	std::string text;
+	NodeWalker walker;
+
+	walker.walk(document, [&text](const Node* node, size_t) {
+		if (node->kind == NodeKind::text) {
+			text.append(static_cast<const Text*>(node)->content);
+		}
+
+		return true;
+	}, [](const Node*) {
+	});
+
+	return text;
+}
+
+static bool report(std::string_view name, bool pass) {
+	std::cout << (pass ? "PASS " : "FAIL ") << name << "\n";
+	return pass;
+}
+
+// A file cached where it was included shallow enough is too deep somewhere else, the cache may not let it through.
+static bool checkDepth() {
+	write("c.gr", "c\n");
+	write("b.gr", "?[c.gr]\n");
+	write("x.gr", "?[b.gr]\n");
+	write("z.gr", "?[b.gr]\n");
+	write("y.gr", "?[z.gr]\n");
+
+	IncludeCache cache;
+	bool pass = parse(cache, "x.gr", 2).empty();
+
+	std::vector<Diagnostic::Code> codes = parse(cache, "y.gr", 2);
+	pass = pass && codes.size() == 1 && codes[0] == Diagnostic::Code::inclusionTooDeep;
+
+	return report("inclusion/cache/depth", pass);
+}
+
+// A cached file that includes a file of the chain it is included from closes a cycle.
+static bool checkCycle() {
+	write("c.gr", "c\n");
+	write("b.gr", "?[c.gr]\n");
+	write("x.gr", "?[b.gr]\n");
+
+	IncludeCache cache;
+	bool pass = parse(cache, "x.gr", Parser::defaultMaximumInclusionDepth).empty();
+
+	// the cached b.gr stays valid, only c.gr changes
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	write("c.gr", "?[b.gr]\n");
+
+	std::vector<Diagnostic::Code> codes = parse(cache, "c.gr", Parser::defaultMaximumInclusionDepth);
+	pass = pass && codes.size() == 1 && codes[0] == Diagnostic::Code::inclusionCycle;
+
+	return report("inclusion/cache/cycle", pass);
+}
+
+// A file included by a cached file changes, the cached file has to be parsed again.
+static bool checkNestedChange() {
+	write("c.gr", "old\n");
+	write("b.gr", "?[c.gr]\n");
+	write("x.gr", "?[b.gr]\n");
+
+	IncludeCache cache;
+	bool pass = textOf(cache, "x.gr") == "old";
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	write("c.gr", "changed\n");
+
+	pass = pass && textOf(cache, "x.gr") == "changed";
+
+	return report("inclusion/cache/nested", pass);
+}
+
+int main() {
+	folder = std::filesystem::temp_directory_path() / "gularen-test-inclusion";
+	std::filesystem::create_directories(folder);
+
+	bool pass = checkDepth();
+	pass = checkCycle() && pass;
+	pass = checkNestedChange() && pass;
+
+	std::filesystem::remove_all(folder);
+
+	return pass ? 0 : 1;
+}
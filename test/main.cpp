@@ -1,15 +1,9 @@
 #include "Gularen/Frontend/Parser.hpp"
 #include "Gularen/Frontend/Node.hpp"
+#include <iostream>
 
 using namespace Gularen;
 
-std::string readFile(const char* path) {
-	std::string content(std::filesystem::file_size(path), '\0');
-	std::ifstream file(path);
-	file.read(content.data(), content.size());
-	return content;
-}
-
 int main(int argc, char** argv) {
 	if (argc < 2) {
 		std::cout << "please specify the file path\n";
@@ -31,11 +25,11 @@ int main(int argc, char** argv) {
 		return 1;
 	}
 
-	std::string content = readFile(argv[1]);
-	std::string_view contentSlice(content.data(), content.size());
+	FileBuffer file;
+	file.open(argv[1]);
 
 	Parser parser;
-	Document* document = parser.parse(contentSlice);
+	Document* document = parser.parse(file.view());
 
 	if (document->children.size() < 2 || 
 		document->children[0]->kind != NodeKind::codeBlock ||
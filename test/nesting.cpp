@@ -0,0 +1,141 @@
+#include "Gularen/Frontend/Parser.hpp"
+#include "Gularen/Frontend/NodeWalker.hpp"
+#include "Gularen/Backend/Json/Composer.hpp"
+#include "Gularen/Backend/Html/Composer.hpp"
+#include "Gularen/Backend/Markdown/Composer.hpp"
+#include <chrono>
+#include <iostream>
+
+using namespace Gularen;
+
+// quotes in quotes, one line indented depth times
+static std::string nestQuotes(size_t depth) {
+	return std::string(depth, '\t') + "x\n";
+}
+
+// bold and italic in turns, each opens inside the other
+static std::string nestStyles(size_t depth) {
+	std::string content;
+
+	for (size_t i = 0; i < depth; i += 1) {
+		content.append(i % 2 == 0 ? "*" : "/");
+	}
+
+	content.append("x");
+
+	for (size_t i = depth; i > 0; i -= 1) {
+		content.append(i % 2 == 1 ? "*" : "/");
+	}
+
+	return content;
+}
+
+// lists in lists, every item on a line of its own one tab further in
+static std::string nestLists(size_t depth) {
+	std::string content;
+
+	for (size_t i = 0; i < depth; i += 1) {
+		content.append(i, '\t');
+		content.append("- x\n");
+	}
+
+	return content;
+}
+
+static size_t depthOf(const Node* node) {
+	NodeWalker walker;
+	size_t depth = 0;
+	size_t deepest = 0;
+
+	walker.walk(node, [&](const Node*, size_t) {
+		depth += 1;
+		deepest = std::max(deepest, depth);
+		return true;
+	}, [&](const Node*) {
+		depth -= 1;
+	});
+
+	return deepest;
+}
+
+struct Run {
+	double seconds;
+	size_t depth;
+	size_t diagnosticCount;
+};
+
+// parses and composes to every target, the fastest of repeat runs
+static Run run(const std::string& content, size_t maximumDepth, size_t repeat = 1) {
+	Run best { 0, 0, 0 };
+
+	for (size_t i = 0; i < repeat; i += 1) {
+		auto start = std::chrono::steady_clock::now();
+
+		Parser parser;
+		parser.setFileInclusion(false);
+		parser.setMaximumDepth(maximumDepth);
+		Document* document = parser.parse(content);
+
+		Json::Composer json;
+		json.compose(document);
+
+		Html::Composer html;
+		html.compose(document);
+
+		Markdown::Composer markdown;
+		markdown.compose(document);
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		if (i == 0 || elapsed.count() < best.seconds) {
+			best = Run { elapsed.count(), depthOf(document), parser.diagnostics().size() };
+		}
+	}
+
+	return best;
+}
+
+// Nesting a million levels deep must neither overflow the stack nor take quadratic time,
+// ten times deeper may not take more than fifteen times longer.
+static bool check(std::string_view name, std::string (*nest)(size_t)) {
+	Run shallow = run(nest(100000), 2000000, 3);
+	Run deep = run(nest(1000000), 2000000, 2);
+	Run limited = run(nest(1000000), Parser::defaultMaximumDepth);
+
+	bool pass = deep.depth > 1000000 && deep.seconds < shallow.seconds * 15 && limited.depth <= Parser::defaultMaximumDepth + 1;
+
+	std::cout << (pass ? "PASS " : "FAIL ") << name;
+	std::cout << " (depth " << deep.depth << " in " << deep.seconds << " s, ";
+	std::cout << "depth " << shallow.depth << " in " << shallow.seconds << " s, ";
+	std::cout << "depth " << limited.depth << " under the default maximum)\n";
+
+	return pass;
+}
+
+// A list costs a line a level and its blocks recurse, the maximum depth bounds them as well.
+// A list within the maximum is parsed and composed in full, one past it stops with a diagnostic,
+// a larger maximum lets the deeper one through.
+static bool checkLists() {
+	size_t levels = Parser::defaultMaximumDepth / 2;
+	Run full = run(nestLists(levels), Parser::defaultMaximumDepth);
+	Run stopped = run(nestLists(levels * 4), Parser::defaultMaximumDepth);
+	Run raised = run(nestLists(levels * 4), Parser::defaultMaximumDepth * 4);
+
+	bool pass = full.depth > levels * 2 && full.diagnosticCount == 0 && stopped.diagnosticCount == 1;
+	pass = pass && raised.depth > levels * 8 && raised.diagnosticCount == 0;
+
+	std::cout << (pass ? "PASS " : "FAIL ") << "nesting/list";
+	std::cout << " (depth " << full.depth << " at " << levels << " levels, ";
+	std::cout << stopped.diagnosticCount << " diagnostic at " << levels * 4 << " levels, ";
+	std::cout << "depth " << raised.depth << " with a maximum of " << Parser::defaultMaximumDepth * 4 << ")\n";
+
+	return pass;
+}
+
+int main() {
+	bool pass = check("nesting/quote", nestQuotes);
+	pass = check("nesting/style", nestStyles) && pass;
+	pass = checkLists() && pass;
+
+	return pass ? 0 : 1;
+}